@@ -0,0 +1,112 @@
+// Cold-start benchmark for `tuisic --cmd`: wall time from spawn to exit
+// when a running instance answers over the control socket. A stand-in
+// server plays the instance, so nothing here needs mpv, a sound card or
+// the network; what is measured is process start-up, static init, the
+// socket round trip and exit. A final run with no server shows what the
+// old always-standalone path costs.
+// Build with -DWITH_BENCHMARKS=ON and run ./tuisic_cold_start_bench [path/to/tuisic].
+
+#include "../src/ai/control_socket.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <spawn.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char **environ;
+
+#ifndef TUISIC_BINARY
+#define TUISIC_BINARY "./tuisic"
+#endif
+
+namespace {
+
+constexpr int kForwardedRuns = 50;
+constexpr int kStandaloneRuns = 5;
+constexpr double kBudgetMs = 10.0; // "a few milliseconds", with headroom
+
+// Milliseconds for one `tuisic --cmd <command>`, or -1 if it failed
+double run_once(const char *binary, const char *command) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+  char *argv[] = {const_cast<char *>(binary), const_cast<char *>("--cmd"),
+                  const_cast<char *>(command), nullptr};
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid;
+  int status = 0;
+  bool ok = posix_spawn(&pid, binary, &actions, nullptr, argv, environ) == 0 &&
+            waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+            WEXITSTATUS(status) == 0;
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  posix_spawn_file_actions_destroy(&actions);
+  return ok ? std::chrono::duration<double, std::milli>(elapsed).count() : -1;
+}
+
+// Returns the median
+double report(const char *name, const char *binary, const char *command,
+              int runs) {
+  std::vector<double> times;
+  for (int i = 0; i < runs; ++i) {
+    double ms = run_once(binary, command);
+    if (ms < 0) {
+      std::printf("%-22s failed to run %s\n", name, binary);
+      return -1;
+    }
+    times.push_back(ms);
+  }
+  std::sort(times.begin(), times.end());
+  auto at = [&](double q) {
+    return times[std::min(times.size() - 1,
+                          static_cast<size_t>(q * times.size()))];
+  };
+  std::printf("%-22s %8.2f min %8.2f median %8.2f p95 %8.2f max  (ms, %d runs)\n",
+              name, times.front(), at(0.5), at(0.95), times.back(), runs);
+  return at(0.5);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *binary = argc > 1 ? argv[1] : TUISIC_BINARY;
+
+  char dir[] = "/tmp/tuisic-bench-XXXXXX";
+  if (!mkdtemp(dir)) {
+    std::perror("mkdtemp");
+    return 1;
+  }
+  std::string socket_path = std::string(dir) + "/control.sock";
+  setenv("TUISIC_CONTROL_SOCKET", socket_path.c_str(), 1);
+
+  double median;
+  {
+    ai::ControlServer server([](const std::string &) {
+      return std::string(R"({"status":"success","data":{"status":"playing"}})");
+    });
+    if (!server.start()) {
+      std::printf("control server: %s\n", server.last_error().c_str());
+      return 1;
+    }
+    report("forwarded (warm-up)", binary, "status", 5);
+    median = report("forwarded --cmd", binary, "status", kForwardedRuns);
+  }
+
+  // No instance: the command falls back to a player of its own
+  report("standalone --cmd", binary, "status", kStandaloneRuns);
+  rmdir(dir);
+
+  if (median < 0) {
+    return 1;
+  }
+  bool within = median <= kBudgetMs;
+  std::printf("\nforwarded median %.2f ms, budget %.0f ms: %s\n", median,
+              kBudgetMs, within ? "ok" : "OVER BUDGET");
+  return within ? 0 : 1;
+}
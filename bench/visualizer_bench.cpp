@@ -0,0 +1,145 @@
+// Micro-benchmark for the visualizer DSP path: cycles and nanoseconds per
+// captured frame for each stage, vectorised kernels against plain loops,
+// and the built-in analyser against cavacore when that is compiled in.
+// Build with -DWITH_BENCHMARKS=ON and run ./tuisic_bench.
+
+#include "../src/audio/audio_frame.hpp"
+#include "../src/audio/spectrum_analyzer.hpp"
+#include "../src/common/simd.hpp"
+#ifdef WITH_CAVA
+#include "../src/audio/visualizer.hpp"
+#endif
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static uint64_t cycles() { return __rdtsc(); }
+static constexpr bool kHaveCycles = true;
+#else
+static uint64_t cycles() { return 0; }
+static constexpr bool kHaveCycles = false;
+#endif
+
+namespace {
+
+constexpr size_t kSamples = AudioFrame::kFrames * AudioFrame::kMaxChannels;
+constexpr size_t kBars = 32;
+constexpr int kIterations = 20000;
+
+// Keeps the optimiser from dropping the work
+volatile double sink;
+
+void report(const char *name, const std::function<void()> &body) {
+  for (int i = 0; i < kIterations / 10; ++i) {
+    body(); // warm up
+  }
+  auto start = std::chrono::steady_clock::now();
+  uint64_t start_cycles = cycles();
+  for (int i = 0; i < kIterations; ++i) {
+    body();
+  }
+  uint64_t total_cycles = cycles() - start_cycles;
+  double ns = std::chrono::duration<double, std::nano>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  if (kHaveCycles) {
+    std::printf("%-26s %10.0f cycles/frame %10.1f ns/frame\n", name,
+                static_cast<double>(total_cycles) / kIterations,
+                ns / kIterations);
+  } else {
+    std::printf("%-26s %10.1f ns/frame\n", name, ns / kIterations);
+  }
+}
+
+} // namespace
+
+int main() {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+  AudioFrame frame;
+  for (auto &sample : frame.samples) {
+    sample = noise(rng);
+  }
+  frame.count = kSamples;
+
+  std::vector<double> wide(kSamples);
+  std::vector<double> window(kSamples);
+  for (size_t i = 0; i < kSamples; ++i) {
+    window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / (kSamples - 1));
+  }
+  std::vector<double> state(kBars, 0.0);
+  std::vector<double> target(kBars);
+  for (auto &bar : target) {
+    bar = std::abs(noise(rng)) * 8.0;
+  }
+
+  std::printf("simd backend: %s, %zu samples/frame, %zu bars\n\n",
+              simd::kBackend, kSamples, kBars);
+
+  report("convert (scalar)", [&] {
+    for (size_t i = 0; i < kSamples; ++i) {
+      wide[i] = static_cast<double>(frame.samples[i]);
+    }
+    sink = wide[kSamples / 2];
+  });
+  report("convert (simd)", [&] {
+    simd::convert(frame.samples.data(), wide.data(), kSamples);
+    sink = wide[kSamples / 2];
+  });
+
+  // Fresh samples every frame, so repeated windowing never hits denormals
+  report("convert+window (scalar)", [&] {
+    for (size_t i = 0; i < kSamples; ++i) {
+      wide[i] = static_cast<double>(frame.samples[i]) * window[i];
+    }
+    sink = wide[kSamples / 2];
+  });
+  report("convert+window (simd)", [&] {
+    simd::convert_windowed(frame.samples.data(), window.data(), wide.data(),
+                           kSamples);
+    sink = wide[kSamples / 2];
+  });
+
+  report("smooth (scalar)", [&] {
+    for (size_t i = 0; i < kBars; ++i) {
+      double rate = target[i] > state[i] ? 0.3 : 0.1;
+      state[i] += (target[i] - state[i]) * rate;
+    }
+    sink = state[0];
+  });
+  report("smooth (simd)", [&] {
+    simd::smooth(state.data(), target.data(), kBars, 0.3, 0.1);
+    sink = state[0];
+  });
+
+  // Both backends get the same stereo frame and produce the same bars, at
+  // every supported bar count
+  SpectrumAnalyzer analyzer;
+#ifdef WITH_CAVA
+  AudioVisualizer visualizer;
+#endif
+  for (int count : bars::kSizes) {
+    char name[64];
+    analyzer.set_num_bars(count);
+    std::snprintf(name, sizeof(name), "builtin fft (%d bars)", count);
+    report(name, [&] {
+      sink = analyzer.process(frame.samples.data(), frame.count)[0];
+    });
+#ifdef WITH_CAVA
+    visualizer.set_num_bars(count);
+    std::snprintf(name, sizeof(name), "cavacore (%d bars)", count);
+    report(name, [&] {
+      sink = visualizer.process(frame.samples.data(), frame.count)[0];
+    });
+#endif
+  }
+
+  return 0;
+}
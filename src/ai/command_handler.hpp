@@ -5,6 +5,7 @@
 #include <sstream>
 #include <memory>
 #include "json_output.hpp"
+#include "../common/lazy.hpp"
 
 // Forward declarations
 class MusicPlayer;
@@ -16,23 +17,22 @@ namespace ai {
 
 class CommandHandler {
 private:
-    std::shared_ptr<MusicPlayer> player;
-    SoundCloud& soundcloud;
-    Saavn& saavn;
+    // Built on first use: "idle" or "latency" never start mpv or curl
+    Lazy<MusicPlayer>& player;
+    Lazy<SoundCloud>& soundcloud;
+    Lazy<Saavn>& saavn;
 
-    // Current playback state
-    std::vector<Track> current_tracks;  // Fetched next tracks (like UI playlist)
-    int current_index = -1;
+    // Current playback state; the queue itself lives in the player
     std::string current_track_name;
     std::string current_artist;
     std::string current_source;  // "saavn", "soundcloud", or "lastfm"
 
 public:
     CommandHandler(
-        std::shared_ptr<MusicPlayer> player_ptr,
-        SoundCloud& sc,
-        Saavn& sv
-    ) : player(player_ptr), soundcloud(sc), saavn(sv) {}
+        Lazy<MusicPlayer>& player_ref,
+        Lazy<SoundCloud>& sc,
+        Lazy<Saavn>& sv
+    ) : player(player_ref), soundcloud(sc), saavn(sv) {}
 
     // Execute a command and return JSON response
     std::string execute(const std::string& command) {
@@ -81,6 +81,15 @@ public:
                 iss >> pos;
                 return handle_seek(pos);
             }
+            else if (cmd == "latency") {
+                return JsonOutput::create_latency();
+            }
+            else if (cmd == "idle") {
+                return JsonOutput::create_idle();
+            }
+            else if (cmd == "visualizer") {
+                return handle_visualizer();
+            }
             else {
                 return JsonOutput::create_error("Unknown command: " + cmd);
             }
@@ -98,9 +107,9 @@ private:
         }
 
         // Search for the track
-        std::vector<Track> search_results = saavn.fetch_tracks(query);
+        std::vector<Track> search_results = saavn->fetch_tracks(query);
         if (search_results.empty()) {
-            search_results = soundcloud.fetch_tracks(query);
+            search_results = soundcloud->fetch_tracks(query);
         }
 
         if (search_results.empty()) {
@@ -118,29 +127,18 @@ private:
         if (selected_track.id != "" && selected_track.source != "lastfm") {
             try {
                 if (selected_track.source == "soundcloud") {
-                    next_tracks = soundcloud.fetch_next_tracks(selected_track.url);
+                    next_tracks = soundcloud->fetch_next_tracks(selected_track.url);
                 } else if (selected_track.source == "saavn") {
-                    next_tracks = saavn.fetch_next_tracks(selected_track.id);
+                    next_tracks = saavn->fetch_next_tracks(selected_track.id);
                 }
             } catch (const std::exception& e) {
                 // If fetching next tracks fails, just play the selected track
             }
         }
 
-        // Build playlist: selected track + next tracks
-        current_tracks.clear();
-        current_tracks.push_back(selected_track);
-        current_tracks.insert(current_tracks.end(), next_tracks.begin(), next_tracks.end());
-        current_index = 0;
-
-        // Create playlist URLs for MPV
-        std::vector<std::string> playlist_urls;
-        for (const auto& track : current_tracks) {
-            playlist_urls.push_back(track.url);
-        }
-
-        // Use create_playlist like the UI does (line 779 in main.cpp)
-        player->create_playlist(playlist_urls);
+        // Build playlist: selected track + next tracks, queued like the UI does
+        next_tracks.insert(next_tracks.begin(), selected_track);
+        player->load_queue(next_tracks);
 
         return JsonOutput::create_success("Now playing: " + selected_track.name + " - " + selected_track.artist);
     }
@@ -156,66 +154,73 @@ private:
     }
 
     std::string handle_next() {
-        if (current_tracks.empty() || current_index < 0) {
+        if (player->get_queue()->empty()) {
             return JsonOutput::create_error("No active playlist");
         }
 
-        // Move to next track in playlist
-        current_index = (current_index + 1) % current_tracks.size();
-
-        // Use player's next_track() method which handles MPV playlist navigation
         player->next_track();
-
-        // Update current track info
-        current_track_name = current_tracks[current_index].name;
-        current_artist = current_tracks[current_index].artist;
+        update_current_track();
 
         return JsonOutput::create_success("Playing next: " + current_track_name + " - " + current_artist);
     }
 
     std::string handle_previous() {
-        if (current_tracks.empty() || current_index < 0) {
+        if (player->get_queue()->empty()) {
             return JsonOutput::create_error("No active playlist");
         }
 
-        // Move to previous track in playlist
-        current_index = (current_index - 1 + current_tracks.size()) % current_tracks.size();
-
-        // Manually play the previous track (player doesn't have previous_track method)
-        player->play(current_tracks[current_index].url);
-
-        // Update current track info
-        current_track_name = current_tracks[current_index].name;
-        current_artist = current_tracks[current_index].artist;
+        player->previous_track();
+        update_current_track();
 
         return JsonOutput::create_success("Playing previous: " + current_track_name + " - " + current_artist);
     }
 
+    void update_current_track() {
+        if (auto track = player->get_queue()->current()) {
+            current_track_name = track->name;
+            current_artist = track->artist;
+            current_source = track->source;
+        }
+    }
+
     std::string handle_stop() {
         player->stop();
         return JsonOutput::create_success("Playback stopped");
     }
 
     std::string handle_search(const std::string& query) {
-        auto tracks = saavn.fetch_tracks(query);
+        auto tracks = saavn->fetch_tracks(query);
         if (tracks.empty()) {
-            tracks = soundcloud.fetch_tracks(query);
+            tracks = soundcloud->fetch_tracks(query);
         }
 
         return JsonOutput::create_search_results(tracks);
     }
 
     std::string handle_status() {
-        std::string status = player->is_playing_state() ? "playing" :
-                           player->is_paused_state() ? "paused" : "stopped";
+        // The interactive instance may have moved the queue since
+        update_current_track();
+        // One snapshot so the fields agree with each other; the position
+        // is read on its own, a moment later at most
+        auto state = player->get_state();
+        std::string status = state->is_playing() ? "playing" :
+                           state->is_paused() ? "paused" : "stopped";
 
         return JsonOutput::create_status(
             status,
             current_track_name,
             current_artist,
             player->get_position(),
-            player->get_duration(),
-            player->get_volume()
+            state->duration,
+            state->volume
+        );
+    }
+
+    // Current bar levels; with ao=null this checks the tap without a sound card
+    std::string handle_visualizer() {
+        return JsonOutput::create_visualizer(
+            player->get_visualizer_source(),
+            *player->get_visualization_snapshot()
         );
     }
 
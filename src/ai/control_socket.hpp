@@ -0,0 +1,304 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "../common/paths.hpp"
+
+namespace ai {
+
+// Local control channel of the interactive instance. `tuisic --cmd ...`
+// sends its command line here and prints the JSON that comes back, so it
+// drives the player that is actually playing and returns without starting
+// mpv, curl or a screen of its own. One request per connection: a command
+// terminated by '\n', answered by one line of JSON.
+
+// $TUISIC_CONTROL_SOCKET, else the runtime dir, else the cache dir; a path
+// too long for sockaddr_un falls back to /tmp
+inline std::string control_socket_path() {
+    if (const char* path = getenv("TUISIC_CONTROL_SOCKET")) {
+        return path;
+    }
+    std::string path;
+    if (const char* runtime = getenv("XDG_RUNTIME_DIR")) {
+        path = std::string(runtime) + "/tuisic.sock";
+    } else {
+        path = paths::get_cache_dir() + "/control.sock";
+    }
+    if (path.size() >= sizeof(sockaddr_un{}.sun_path)) {
+        path = "/tmp/tuisic-" + std::to_string(::getuid()) + ".sock";
+    }
+    return path;
+}
+
+namespace detail {
+
+// SOCK_CLOEXEC, accept4 and pipe2 are missing on macOS
+inline int cloexec(int fd) {
+    if (fd >= 0) {
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+
+inline int stream_socket() {
+    int fd = cloexec(::socket(AF_UNIX, SOCK_STREAM, 0));
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    if (fd >= 0) {
+        ::setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+    return fd;
+}
+
+inline bool make_address(const std::string& path, sockaddr_un& address) {
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// -1 with errno set from socket() or connect()
+inline int connect_to(const std::string& path) {
+    sockaddr_un address;
+    if (!make_address(path, address)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = stream_socket();
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+inline bool write_all(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+#ifdef MSG_NOSIGNAL
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+#else
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Reads until '\n' or EOF; false on error or when `timeout_ms` passes
+// without data
+inline bool read_line(int fd, std::string& line, int timeout_ms) {
+    char buffer[4096];
+    while (true) {
+        pollfd ready{fd, POLLIN, 0};
+        int count = ::poll(&ready, 1, timeout_ms);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) {
+            return false;
+        }
+        ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) {
+            return !line.empty();
+        }
+        line.append(buffer, static_cast<size_t>(n));
+        size_t end = line.find('\n');
+        if (end != std::string::npos) {
+            line.resize(end);
+            return true;
+        }
+    }
+}
+
+// Only the user running the instance may drive it, whatever the socket
+// file's permissions (e.g. in a shared /tmp)
+inline bool peer_is_owner(int fd) {
+#if defined(SO_PEERCRED)
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+    return ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == 0 &&
+           credentials.uid == ::getuid();
+#else
+    uid_t uid;
+    gid_t gid;
+    return ::getpeereid(fd, &uid, &gid) == 0 && uid == ::getuid();
+#endif
+}
+
+} // namespace detail
+
+enum class SendResult {
+    Answered,   // `response` holds the instance's reply
+    NoInstance, // nobody listening; the caller may run the command itself
+    Failed,     // an instance took the command but gave no (timely) answer
+};
+
+// Client side. NoInstance comes back quickly and only when there is no
+// socket or nothing accepts on it. Once an instance has the command it
+// may be acting on it, so running it again here would e.g. start a
+// second player; a slow or broken reply is Failed, never NoInstance.
+inline SendResult send_command(const std::string& command, std::string& response,
+                               int timeout_ms = 30000) {
+    int fd = detail::connect_to(control_socket_path());
+    if (fd < 0) {
+        return errno == ENOENT || errno == ECONNREFUSED || errno == ENAMETOOLONG
+                   ? SendResult::NoInstance
+                   : SendResult::Failed;
+    }
+    response.clear();
+    bool ok = detail::write_all(fd, command + "\n") &&
+              detail::read_line(fd, response, timeout_ms);
+    ::close(fd);
+    return ok ? SendResult::Answered : SendResult::Failed;
+}
+
+// Server side, owned by the interactive instance. Requests are handled
+// one at a time on the server's own thread.
+class ControlServer {
+public:
+    using Handler = std::function<std::string(const std::string& command)>;
+
+    explicit ControlServer(Handler handler) : handler(std::move(handler)) {}
+    ~ControlServer() { stop(); }
+
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // False if the socket can't be bound or another instance owns it
+    bool start() {
+        path = control_socket_path();
+        sockaddr_un address;
+        if (!detail::make_address(path, address)) {
+            error = "socket path too long: " + path;
+            path.clear();
+            return false;
+        }
+        int probe = detail::connect_to(path);
+        if (probe >= 0) {
+            ::close(probe);
+            error = "another instance is listening on " + path;
+            path.clear();
+            return false;
+        }
+        // A socket left behind by an instance that crashed is replaced;
+        // anything else at that path is not ours to delete
+        struct stat existing;
+        if (::lstat(path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                error = path + " exists and is not a socket";
+                path.clear();
+                return false;
+            }
+            ::unlink(path.c_str());
+        }
+        paths::ensure_directory_exists(std::filesystem::path(path).parent_path().string());
+
+        // Created 0600 rather than chmod'ed after bind, so there is no
+        // window in which other users can connect
+        listen_fd = detail::stream_socket();
+        mode_t previous_mask = ::umask(077);
+        bool bound = listen_fd >= 0 &&
+                     ::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        ::umask(previous_mask);
+        if (!bound ||
+            ::listen(listen_fd, 8) != 0 ||
+            ::pipe(wake_fds) != 0) {
+            error = "control socket " + path + ": " + std::strerror(errno);
+            stop();
+            return false;
+        }
+        detail::cloexec(wake_fds[0]);
+        detail::cloexec(wake_fds[1]);
+        stopping = false;
+        worker = std::thread([this] { serve(); });
+        return true;
+    }
+
+    void stop() {
+        stopping = true;
+        if (wake_fds[1] >= 0) {
+            [[maybe_unused]] ssize_t ignored = ::write(wake_fds[1], "x", 1);
+        }
+        if (worker.joinable()) {
+            worker.join();
+        }
+        for (int* fd : {&listen_fd, &wake_fds[0], &wake_fds[1]}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+        if (!path.empty()) {
+            ::unlink(path.c_str());
+            path.clear();
+        }
+    }
+
+    const std::string& last_error() const { return error; }
+
+private:
+    static constexpr int kRequestTimeoutMs = 2000; // a client that never writes
+
+    Handler handler;
+    std::string path;
+    std::string error;
+    int listen_fd = -1;
+    int wake_fds[2] = {-1, -1};
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+
+    void serve() {
+        while (!stopping) {
+            pollfd fds[2] = {{listen_fd, POLLIN, 0}, {wake_fds[0], POLLIN, 0}};
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (stopping || (fds[1].revents & POLLIN)) {
+                break;
+            }
+            int client = detail::cloexec(::accept(listen_fd, nullptr, nullptr));
+            if (client < 0) {
+                continue;
+            }
+            if (!detail::peer_is_owner(client)) {
+                ::close(client);
+                continue;
+            }
+            std::string command;
+            if (detail::read_line(client, command, kRequestTimeoutMs)) {
+                detail::write_all(client, handler(command) + "\n");
+            }
+            ::close(client);
+        }
+    }
+};
+
+} // namespace ai
@@ -4,9 +4,13 @@
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 #include "../common/Track.h"
+#include "../common/latency_tracker.hpp"
+#include "../common/idle_state.hpp"
 
 namespace ai {
 
@@ -32,6 +36,57 @@ public:
         doc.AddMember("duration", duration, allocator);
         doc.AddMember("volume", volume, allocator);
 
+        // Enter-to-first-audio breakdown collected by this process
+        rapidjson::Value startup(rapidjson::kObjectType);
+        latency::tracker().append_json(startup, allocator);
+        doc.AddMember("latency", startup, allocator);
+
+        return document_to_string(doc);
+    }
+
+    // Latency breakdown from the dump the interactive instance keeps updated
+    static std::string create_latency() {
+        std::ifstream file(latency::Tracker::dump_path());
+        if (!file.good()) {
+            return latency::tracker().to_json();
+        }
+        std::string json((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+        rapidjson::Document doc;
+        if (doc.Parse(json.c_str()).HasParseError() || !doc.IsObject()) {
+            return create_error("Corrupt latency dump: " + latency::Tracker::dump_path());
+        }
+        return document_to_string(doc);
+    }
+
+    // Idle time and background wakeups, from the interactive instance's dump
+    static std::string create_idle() {
+        std::ifstream file(idle::Coordinator::dump_path());
+        if (!file.good()) {
+            return idle::coordinator().to_json();
+        }
+        std::string json((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+        rapidjson::Document doc;
+        if (doc.Parse(json.c_str()).HasParseError() || !doc.IsObject()) {
+            return create_error("Corrupt idle dump: " + idle::Coordinator::dump_path());
+        }
+        return document_to_string(doc);
+    }
+
+    // Visualizer source and bar levels (0..1), left to right
+    static std::string create_visualizer(const std::string& source, const std::vector<double>& levels) {
+        rapidjson::Document doc;
+        doc.SetObject();
+        auto& allocator = doc.GetAllocator();
+
+        doc.AddMember("source", rapidjson::Value(source.c_str(), allocator), allocator);
+        rapidjson::Value bars(rapidjson::kArrayType);
+        for (double level : levels) {
+            bars.PushBack(level, allocator);
+        }
+        doc.AddMember("bars", bars, allocator);
+
         return document_to_string(doc);
     }
 
@@ -121,6 +121,8 @@ private:
         tools.PushBack(create_tool("music_seek", "Seek to position",
             R"json({"position": {"type": "number", "description": "Position in seconds"}})json", allocator), allocator);
 
+        tools.PushBack(create_tool("music_visualizer", "Get the visualizer's current bar levels", "{}", allocator), allocator);
+
         result.AddMember("tools", tools, allocator);
         doc.AddMember("result", result, allocator);
 
@@ -180,6 +182,9 @@ private:
                 arguments["position"].GetDouble() : 0.0;
             command = "seek " + std::to_string(pos);
         }
+        else if (tool_name == "music_visualizer") {
+            command = "visualizer";
+        }
         else {
             return create_error_response(id, "Unknown tool: " + tool_name);
         }
@@ -1,11 +1,12 @@
 #pragma once
 
-#ifdef WITH_CAVA
+#ifdef WITH_PULSEAUDIO
 
 #include <pulse/pulseaudio.h>
 #include <pulse/simple.h>
+#include "audio_frame.hpp"
 #include <atomic>
-#include <functional>
+#include <memory>
 #include <thread>
 #include <vector>
 #include <cstring>
@@ -16,11 +17,11 @@ private:
     pa_simple* pulse_connection = nullptr;
     std::thread capture_thread;
     std::atomic<bool> should_stop{false};
-    std::function<void(const std::vector<double>&)> callback;
+    std::shared_ptr<AudioFrameQueue> frames;
 
     static constexpr int SAMPLE_RATE = 44100;
     static constexpr int CHANNELS = 2;
-    static constexpr int BUFFER_SIZE = 2048;
+    static constexpr int BUFFER_SIZE = AudioFrame::kFrames;
 
 public:
     AudioCapture() = default;
@@ -29,8 +30,9 @@ public:
         stop();
     }
 
-    void set_callback(std::function<void(const std::vector<double>&)> cb) {
-        callback = std::move(cb);
+    // Captured frames are written straight into this queue; set before start()
+    void set_output(std::shared_ptr<AudioFrameQueue> queue) {
+        frames = std::move(queue);
     }
 
     bool start(const char* device_name = nullptr) {
@@ -107,18 +109,27 @@ public:
 
 private:
     void capture_loop() {
-        std::vector<float> buffer(BUFFER_SIZE * CHANNELS);
-        std::vector<double> double_buffer(BUFFER_SIZE * CHANNELS);
+        // Where reads go when the consumer has fallen behind; the data
+        // still has to be drained from PulseAudio
+        std::vector<float> overflow(BUFFER_SIZE * CHANNELS);
+        const size_t samples = BUFFER_SIZE * CHANNELS;
 
         int error;
         int read_count = 0;
 
         std::cout << "[AudioCapture] Capture loop started, waiting for audio data..." << std::endl;
 
+        if (!frames) {
+            std::cerr << "[AudioCapture] Warning: No output queue set!" << std::endl;
+        }
+
         while (!should_stop) {
-            // Read audio data from PulseAudio
-            if (pa_simple_read(pulse_connection, buffer.data(),
-                              buffer.size() * sizeof(float), &error) < 0) {
+            // Read straight into a preallocated ring slot
+            AudioFrame* frame = frames ? frames->write_slot() : nullptr;
+            float* target = frame ? frame->samples.data() : overflow.data();
+
+            if (pa_simple_read(pulse_connection, target,
+                              samples * sizeof(float), &error) < 0) {
                 std::cerr << "[AudioCapture] PulseAudio read error: " << pa_strerror(error) << std::endl;
                 break;
             }
@@ -128,16 +139,13 @@ private:
                 std::cout << "[AudioCapture] Read " << read_count << " audio buffers" << std::endl;
             }
 
-            // Convert float to double and pass to callback
-            if (callback) {
-                for (size_t i = 0; i < buffer.size(); i++) {
-                    double_buffer[i] = static_cast<double>(buffer[i]);
-                }
-                callback(double_buffer);
-            } else {
-                if (read_count == 1) {
-                    std::cerr << "[AudioCapture] Warning: No callback set!" << std::endl;
-                }
+            if (frame) {
+                frame->count = samples;
+                frame->channels = CHANNELS;
+                frame->bands = 0;
+                frames->commit();
+            } else if (frames) {
+                frames->drop();
             }
         }
 
@@ -145,4 +153,4 @@ private:
     }
 };
 
-#endif // WITH_CAVA
+#endif // WITH_PULSEAUDIO
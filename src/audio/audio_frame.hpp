@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../common/spsc_ring.hpp"
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+// One capture read of interleaved float samples, preallocated in the ring.
+// Sources that analyse upstream (the mpv tap) send band levels instead.
+struct AudioFrame {
+  static constexpr size_t kFrames = 2048;
+  static constexpr size_t kMaxChannels = 2;
+
+  std::array<float, kFrames * kMaxChannels> samples{};
+  size_t count = 0; // interleaved samples actually filled
+  int channels = 2;
+  int bands = 0; // > 0: samples holds that many band levels in 0..1
+};
+
+// Frames from the capture thread to the DSP thread. Pushing never blocks:
+// the producer only pokes a condition variable after committing, and the
+// consumer waits with a timeout so a missed poke costs at most one period.
+class AudioFrameQueue {
+public:
+  static constexpr size_t kCapacity = 8;
+
+  AudioFrame *write_slot() { return ring.write_slot(); }
+
+  void commit() {
+    ring.commit();
+    ready.notify_one();
+  }
+
+  void drop() { ring.drop(); }
+
+  const AudioFrame *read_slot() { return ring.read_slot(); }
+  void release() { ring.release(); }
+
+  // Consumer: true once a frame is waiting; false on timeout or interrupt
+  bool wait(std::chrono::milliseconds timeout) {
+    if (!ring.empty()) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    ready.wait_for(lock, timeout,
+                   [this] { return !ring.empty() || interrupted; });
+    return !ring.empty();
+  }
+
+  // Releases a consumer in a long wait for good, e.g. on shutdown
+  void interrupt() {
+    {
+      std::lock_guard<std::mutex> lock(wait_mutex);
+      interrupted = true;
+    }
+    ready.notify_all();
+  }
+
+  uint64_t dropped_count() const { return ring.dropped_count(); }
+
+private:
+  SpscRing<AudioFrame, kCapacity> ring;
+  std::mutex wait_mutex; // the consumer, and interrupt() once
+  std::condition_variable ready;
+  bool interrupted = false;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+
+// Visualizer bar counts. The pane asks for whatever fits its width, and
+// that is snapped to one of the supported sizes. The sidebar tops out at
+// 68 columns and a bar takes two, so 32 is the most the pane can ever ask
+// for. The per-frame kernels take the count at run time; with two sizes
+// and loops this short, per-size instances bought nothing measurable.
+namespace bars {
+
+constexpr int kSizes[] = {16, 32};
+constexpr int kMin = 16;
+constexpr int kMax = 32;
+
+// Largest supported count not above `wanted`, never below kMin
+inline int snap(int wanted) {
+  int result = kMin;
+  for (int size : kSizes) {
+    if (size <= wanted) {
+      result = size;
+    }
+  }
+  return result;
+}
+
+// Backend output is n bars per channel, left channel first. Folds it to
+// one mono bar each, scaled and clamped to 0..1.
+inline void fold(int n, const double *raw, size_t raw_size, double *targets,
+                 double sensitivity) {
+  if (raw_size >= 2 * static_cast<size_t>(n)) {
+    for (int i = 0; i < n; ++i) {
+      targets[i] =
+          std::clamp((raw[i] + raw[n + i]) * 0.5 * sensitivity, 0.0, 1.0);
+    }
+  } else if (raw_size >= static_cast<size_t>(n)) {
+    for (int i = 0; i < n; ++i) {
+      targets[i] = std::clamp(raw[i] * sensitivity, 0.0, 1.0);
+    }
+  } else {
+    std::fill(targets, targets + n, 0.0);
+  }
+}
+
+// Band levels already analysed upstream, any count: each bar takes the
+// loudest band it covers, or the nearest one when there are fewer bands
+inline void regroup(int n, const float *bands, size_t count, double *targets,
+                    double sensitivity) {
+  if (count == 0) {
+    std::fill(targets, targets + n, 0.0);
+    return;
+  }
+  for (int i = 0; i < n; ++i) {
+    size_t first = i * count / n;
+    size_t last = std::max(first + 1, (i + 1) * count / n);
+    double peak = 0;
+    for (size_t b = first; b < last; ++b) {
+      peak = std::max(peak, static_cast<double>(bands[b]));
+    }
+    targets[i] = std::clamp(peak * sensitivity, 0.0, 1.0);
+  }
+}
+
+} // namespace bars
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Network buffering presets, selected by player.buffer_profile in the config
+struct BufferProfile {
+  std::string name;
+  int demuxer_max_mib = 32;
+  int demuxer_back_mib = 8;
+  double readahead_secs = 10;
+  double cache_secs = 30;
+
+  std::vector<std::pair<std::string, std::string>> mpv_options() const {
+    return {
+        {"cache", "yes"},
+        {"demuxer-max-bytes", std::to_string(demuxer_max_mib) + "MiB"},
+        {"demuxer-max-back-bytes", std::to_string(demuxer_back_mib) + "MiB"},
+        {"demuxer-readahead-secs", std::to_string(readahead_secs)},
+        {"cache-secs", std::to_string(cache_secs)},
+    };
+  }
+
+  // Start playing as soon as a couple of seconds are buffered
+  static BufferProfile low_latency() { return {"low-latency", 8, 2, 2, 5}; }
+  static BufferProfile balanced() { return {"balanced", 32, 8, 10, 30}; }
+  // Small machines: keep the demuxer cache to a few MiB
+  static BufferProfile low_memory() { return {"low-memory", 4, 1, 5, 10}; }
+
+  // "adaptive" starts from low-latency and is resized by AdaptiveBuffer
+  static BufferProfile from_name(const std::string &name) {
+    if (name == "low-latency" || name == "adaptive") {
+      return low_latency();
+    }
+    if (name == "low-memory") {
+      return low_memory();
+    }
+    return balanced();
+  }
+};
+
+// Resizes readahead from what the stream actually delivers. Throughput
+// comes from mpv's cache-speed, the stream rate from audio-bitrate and
+// stalls from paused-for-cache. A fast link with plenty of headroom keeps
+// a short readahead; a slow or stalling one buys more seconds.
+class AdaptiveBuffer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit AdaptiveBuffer(BufferProfile start = BufferProfile::low_latency())
+      : current(std::move(start)) {}
+
+  void on_throughput(double bytes_per_sec) {
+    if (bytes_per_sec <= 0) {
+      return;
+    }
+    // Smooth out bursty readings
+    throughput = throughput > 0 ? throughput * 0.8 + bytes_per_sec * 0.2
+                                : bytes_per_sec;
+  }
+
+  void on_bitrate(double bits_per_sec) {
+    if (bits_per_sec > 0) {
+      bitrate = bits_per_sec;
+    }
+  }
+
+  void on_stall() { stalls++; }
+
+  // New track: forget the old stream's rate but keep the stall history
+  void on_track_change() {
+    throughput = 0;
+    bitrate = 0;
+  }
+
+  // Returns a new profile when it differs enough to be worth applying
+  std::optional<BufferProfile> update(Clock::time_point now = Clock::now()) {
+    if (throughput <= 0 || bitrate <= 0 ||
+        now - last_applied < std::chrono::seconds(5)) {
+      return std::nullopt;
+    }
+
+    double stream_rate = bitrate / 8.0;
+    double headroom = throughput / stream_rate;
+
+    // Less headroom and more stalls both call for a deeper buffer
+    double readahead = 2.0 + 20.0 / std::max(headroom, 0.5) + 10.0 * stalls;
+    readahead = std::clamp(readahead, 2.0, 120.0);
+
+    double wanted_mib = stream_rate * readahead * 2.0 / (1024.0 * 1024.0);
+    int max_mib = std::clamp(static_cast<int>(std::ceil(wanted_mib)), 2, 64);
+
+    bool changed =
+        std::abs(readahead - current.readahead_secs) >
+            current.readahead_secs * 0.2 ||
+        max_mib != current.demuxer_max_mib;
+    if (!changed) {
+      return std::nullopt;
+    }
+
+    current.name = "adaptive";
+    current.readahead_secs = std::round(readahead);
+    current.cache_secs = std::max(current.readahead_secs * 2, 10.0);
+    current.demuxer_max_mib = max_mib;
+    current.demuxer_back_mib = std::max(1, max_mib / 4);
+    last_applied = now;
+    return current;
+  }
+
+private:
+  BufferProfile current;
+  double throughput = 0;
+  double bitrate = 0;
+  int stalls = 0;
+  Clock::time_point last_applied{};
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <optional>
+
+// Sits between the UI/IPC and mpv. Bursts of seeks and volume changes are
+// merged here and dispatched from the player's event thread at a bounded
+// rate, so holding a key doesn't queue dozens of commands on a network
+// stream.
+class CommandScheduler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Batch {
+    std::optional<double> seek_to; // absolute position in seconds
+    std::optional<int> volume;
+  };
+
+  explicit CommandScheduler(
+      Clock::duration seek_interval = std::chrono::milliseconds(150),
+      Clock::duration volume_interval = std::chrono::milliseconds(50))
+      : seek_interval(seek_interval), volume_interval(volume_interval) {}
+
+  // Relative seeks stack on top of whatever target is already pending or
+  // in flight, so five quick presses of +5s land 25s ahead.
+  void seek_relative(double delta, double position, double duration) {
+    std::lock_guard<std::mutex> lock(mutex);
+    double base = pending_seek ? *pending_seek
+                  : inflight_seek ? *inflight_seek
+                                  : position;
+    pending_seek = clamp_position(base + delta, duration);
+  }
+
+  void seek_absolute(double target, double duration) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_seek = clamp_position(target, duration);
+  }
+
+  // Only the latest volume survives
+  void set_volume(int volume) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_volume = std::clamp(volume, 0, 100);
+  }
+
+  // Called by the event thread; returns what is due now
+  Batch take_due(Clock::time_point now = Clock::now()) {
+    std::lock_guard<std::mutex> lock(mutex);
+    Batch batch;
+    if (pending_seek && now - last_seek >= seek_interval) {
+      batch.seek_to = pending_seek;
+      inflight_seek = pending_seek;
+      pending_seek.reset();
+      last_seek = now;
+    }
+    if (pending_volume && now - last_volume >= volume_interval) {
+      batch.volume = pending_volume;
+      pending_volume.reset();
+      last_volume = now;
+    }
+    return batch;
+  }
+
+  // mpv finished the last seek; relative seeks go back to the live position
+  void seek_completed() {
+    std::lock_guard<std::mutex> lock(mutex);
+    inflight_seek.reset();
+  }
+
+  // A new track: seeks aimed at the old one are dropped. A pending volume
+  // stays; mpv keeps its volume across loadfile, and the UI already shows it.
+  void reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending_seek.reset();
+    inflight_seek.reset();
+  }
+
+  // How long the event thread may block before something throttled is due
+  double wait_timeout(double idle_timeout,
+                      Clock::time_point now = Clock::now()) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Clock::duration wait = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(idle_timeout));
+    if (pending_seek) {
+      wait = std::min(wait, remaining(last_seek + seek_interval, now));
+    }
+    if (pending_volume) {
+      wait = std::min(wait, remaining(last_volume + volume_interval, now));
+    }
+    return std::chrono::duration<double>(wait).count();
+  }
+
+private:
+  Clock::duration seek_interval;
+  Clock::duration volume_interval;
+
+  mutable std::mutex mutex;
+  std::optional<double> pending_seek;
+  std::optional<double> inflight_seek;
+  std::optional<int> pending_volume;
+  Clock::time_point last_seek{};
+  Clock::time_point last_volume{};
+
+  static double clamp_position(double target, double duration) {
+    target = std::max(target, 0.0);
+    if (duration > 0) {
+      // Stay just short of the end so a seek never skips the track
+      target = std::min(target, std::max(duration - 1.0, 0.0));
+    }
+    return target;
+  }
+
+  static Clock::duration remaining(Clock::time_point due,
+                                   Clock::time_point now) {
+    return due > now ? due - now : Clock::duration::zero();
+  }
+};
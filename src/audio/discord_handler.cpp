@@ -104,20 +104,15 @@ public:
 class TUIDiscordIntegration {
 private:
   std::unique_ptr<DiscordRPCHandler> discord_handler;
-  std::vector<Track> &track_data;
-  std::vector<Track> &next_tracks;
-  int &current_track_index;
+  std::shared_ptr<PlayQueue> queue;
   std::shared_ptr<MusicPlayer> player;
+  int queue_listener = -1;
 
 public:
   TUIDiscordIntegration(
-      std::vector<Track> &tracks,
-      std::vector<Track> &next_track_list,
-      int &track_index,
+      std::shared_ptr<PlayQueue> play_queue,
       std::shared_ptr<MusicPlayer> player_instance)
-      : track_data(tracks),
-        next_tracks(next_track_list),
-        current_track_index(track_index),
+      : queue(std::move(play_queue)),
         player(player_instance) {}
 
   void setup(const std::string& client_id) {
@@ -126,23 +121,19 @@ public:
 
     discord_handler->setTrackCallbacks(
         [this]() -> std::string {
-          // Use next_tracks if available, otherwise fall back to track_data
-          auto &source = !next_tracks.empty() ? next_tracks : track_data;
-          return (source.empty() || current_track_index >= source.size())
-                     ? ""
-                     : source[current_track_index].name;
+          auto track = queue->current();
+          return track ? track->name : "";
         },
         [this]() -> std::string {
-          // Use next_tracks if available, otherwise fall back to track_data
-          auto &source = !next_tracks.empty() ? next_tracks : track_data;
-          return (source.empty() || current_track_index >= source.size())
-                     ? ""
-                     : source[current_track_index].artist;
+          auto track = queue->current();
+          return track ? track->artist : "";
         },
         [this]() -> bool {
           return player && player->is_playing_state();
         });
 
+    queue_listener = queue->add_listener([this]() { notifyTrackChange(); });
+
     // Initial presence update
     discord_handler->updatePresence();
   }
@@ -160,6 +151,8 @@ public:
   }
 
   ~TUIDiscordIntegration() {
-    // Destructor handles cleanup automatically
+    if (queue_listener >= 0) {
+      queue->remove_listener(queue_listener);
+    }
   }
 };
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Real-input FFT for power-of-two sizes. The n real samples are packed
+// into an n/2-point complex transform (radix-4 stages, plus one radix-2
+// stage when log2(n/2) is odd) and split into n/2+1 bins afterwards. All
+// twiddles and the bit-reversal permutation are computed once up front.
+class RealFft {
+public:
+  // Plain struct instead of std::complex so products stay inline without
+  // the NaN-recovery calls std::complex multiplication makes
+  struct Complex {
+    double re = 0;
+    double im = 0;
+  };
+
+  explicit RealFft(size_t size) : n(size), half(size / 2) {
+    if (n < 4 || (n & (n - 1)) != 0) {
+      throw std::invalid_argument("FFT size must be a power of two >= 4");
+    }
+
+    // W_n^k for k < n/2; the n/2-point transform uses every other entry
+    twiddles.resize(half);
+    for (size_t k = 0; k < half; ++k) {
+      double angle = -2.0 * M_PI * k / n;
+      twiddles[k] = {std::cos(angle), std::sin(angle)};
+    }
+
+    size_t bits = 0;
+    while ((size_t{1} << bits) < half) {
+      bits++;
+    }
+    odd_stages = bits % 2 == 1;
+    bit_reverse.resize(half);
+    for (size_t i = 0; i < half; ++i) {
+      size_t reversed = 0;
+      for (size_t b = 0; b < bits; ++b) {
+        reversed |= ((i >> b) & 1) << (bits - 1 - b);
+      }
+      bit_reverse[i] = reversed;
+    }
+
+    work.resize(half);
+  }
+
+  size_t size() const { return n; }
+  size_t bins() const { return half + 1; }
+
+  // in: n real samples; out: n/2+1 bins, DC first
+  void forward(const double *in, Complex *out) {
+    for (size_t i = 0; i < half; ++i) {
+      work[bit_reverse[i]] = {in[2 * i], in[2 * i + 1]};
+    }
+    transform();
+
+    // Untangle the even/odd halves packed into re/im
+    out[0] = {work[0].re + work[0].im, 0};
+    out[half] = {work[0].re - work[0].im, 0};
+    for (size_t k = 1; k < half; ++k) {
+      const Complex &a = work[k];
+      const Complex &b = work[half - k];
+      Complex even = {(a.re + b.re) * 0.5, (a.im - b.im) * 0.5};
+      Complex odd = {(a.re - b.re) * 0.5, (a.im + b.im) * 0.5};
+      Complex t = mul(twiddles[k], odd);
+      out[k] = {even.re + t.im, even.im - t.re};
+    }
+  }
+
+private:
+  size_t n;
+  size_t half;
+  bool odd_stages = false;
+  std::vector<Complex> twiddles;
+  std::vector<size_t> bit_reverse;
+  std::vector<Complex> work;
+
+  static Complex mul(const Complex &a, const Complex &b) {
+    return {a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re};
+  }
+
+  // In-place n/2-point DIT on bit-reversed input
+  void transform() {
+    Complex *x = work.data();
+    size_t span = 1;
+
+    if (odd_stages) {
+      for (size_t k = 0; k < half; k += 2) {
+        Complex a = x[k];
+        Complex b = x[k + 1];
+        x[k] = {a.re + b.re, a.im + b.im};
+        x[k + 1] = {a.re - b.re, a.im - b.im};
+      }
+      span = 2;
+    }
+
+    // Each pass fuses two radix-2 stages (span -> 2*span -> 4*span)
+    for (; span < half; span *= 4) {
+      size_t step = half / (4 * span); // W_{4*span}^k == twiddles[2*k*step]
+      for (size_t block = 0; block < half; block += 4 * span) {
+        for (size_t k = 0; k < span; ++k) {
+          const Complex &v = twiddles[2 * k * step]; // W_{4*span}^k
+          const Complex &w = twiddles[4 * k * step]; // W_{2*span}^k
+
+          Complex *p = x + block + k;
+          Complex a1 = mul(w, p[span]);
+          Complex a3 = mul(w, p[3 * span]);
+          Complex b0 = {p[0].re + a1.re, p[0].im + a1.im};
+          Complex b1 = {p[0].re - a1.re, p[0].im - a1.im};
+          Complex b2 = {p[2 * span].re + a3.re, p[2 * span].im + a3.im};
+          Complex b3 = {p[2 * span].re - a3.re, p[2 * span].im - a3.im};
+
+          Complex c2 = mul(v, b2);
+          Complex c3 = mul(v, b3);
+          // W_{4*span}^(k+span) = -j * W_{4*span}^k
+          Complex d3 = {c3.im, -c3.re};
+
+          p[0] = {b0.re + c2.re, b0.im + c2.im};
+          p[2 * span] = {b0.re - c2.re, b0.im - c2.im};
+          p[span] = {b1.re + d3.re, b1.im + d3.im};
+          p[3 * span] = {b1.re - d3.re, b1.im - d3.im};
+        }
+      }
+    }
+  }
+};
@@ -1,4 +1,5 @@
 #include "lyrics_fetcher.hpp"
+#include "../services/http_limits.hpp"
 #include <curl/curl.h>
 #include <sstream>
 #include <algorithm>
@@ -48,6 +49,7 @@ std::optional<std::string> LyricsFetcher::fetch_lyrics(const std::string& artist
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
     curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    http::apply_limits(curl);
     curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
 
     // Set user agent
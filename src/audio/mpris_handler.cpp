@@ -56,7 +56,8 @@ public:
   }
 
   void startEventLoop() {
-    std::thread([this] { connection->enterEventLoop(); }).detach();
+    // Owned so cleanup() can leave the loop and join it
+    event_thread = std::thread([this] { connection->enterEventLoop(); });
     updateMetadata();
     updatePlaybackStatus();
   }
@@ -170,7 +171,7 @@ private:
                                             sdbus::Signature{""},
                                             {},
                                             [this](sdbus::MethodCall call) {
-                                              // player->previous_track();
+                                              player->previous_track();
                                               if (on_previous_track)
                                                 on_previous_track();
                                               updateMetadata();
@@ -283,9 +284,10 @@ private:
           sdbus::Variant(std::vector<std::string>{get_track_artist()});
     }
 
+    auto state = player->get_state();
     metadata["position"] = sdbus::Variant(int64_t(player->get_position() * 1000000));
     metadata["mpris:length"] =
-        sdbus::Variant(int64_t(player->get_duration() * 1000000));
+        sdbus::Variant(int64_t(state->duration * 1000000));
         //sdbus::Variant(int64_t(total_duration * 1000000));
 
 
@@ -307,13 +309,12 @@ private:
 class TUIMPRISIntegration {
 private:
   std::unique_ptr<MPRISHandler> mpris_handler;
-  std::vector<Track> &track_data; // Your TUI track data
-  std::vector<Track> &next_tracks; // The actual playing playlist
-  int &current_track_index;
+  std::shared_ptr<PlayQueue> queue; // The actual playing playlist
+  int queue_listener = -1;
 
 public:
-  TUIMPRISIntegration(std::vector<Track> &tracks, std::vector<Track> &next_track_list, int &track_index)
-      : track_data(tracks), next_tracks(next_track_list), current_track_index(track_index) {}
+  explicit TUIMPRISIntegration(std::shared_ptr<PlayQueue> play_queue)
+      : queue(std::move(play_queue)) {}
 
   void setup(std::shared_ptr<MusicPlayer> player) {
     mpris_handler = std::make_unique<MPRISHandler>(player);
@@ -321,39 +322,21 @@ public:
 
     mpris_handler->setTrackCallbacks(
         [this]() -> std::string {
-          // Use next_tracks if available, otherwise fall back to track_data
-          auto &source = !next_tracks.empty() ? next_tracks : track_data;
-          return (source.empty() || current_track_index >= source.size())
-                     ? ""
-                     : source[current_track_index].id;
+          auto track = queue->current();
+          return track ? track->id : "";
         },
         [this]() -> std::string {
-          // Use next_tracks if available, otherwise fall back to track_data
-          auto &source = !next_tracks.empty() ? next_tracks : track_data;
-          return (source.empty() || current_track_index >= source.size())
-                     ? ""
-                     : source[current_track_index].name;
+          auto track = queue->current();
+          return track ? track->name : "";
         },
         [this]() -> std::string {
-          // Use next_tracks if available, otherwise fall back to track_data
-          auto &source = !next_tracks.empty() ? next_tracks : track_data;
-          return (source.empty() || current_track_index >= source.size())
-                     ? ""
-                     : source[current_track_index].artist;
+          auto track = queue->current();
+          return track ? track->artist : "";
         },
-        [this]() {
-          // Next track via MPRIS
-          auto &source = !next_tracks.empty() ? next_tracks : track_data;
-          if (current_track_index < source.size() - 1) {
-            current_track_index++;
-          }
-        },
-        [this]() {
-          // Previous track via MPRIS
-          if (current_track_index > 0) {
-            current_track_index--;
-          }
-        });
+        nullptr);
+
+    // Every queue move, from any source, refreshes the exported metadata
+    queue_listener = queue->add_listener([this]() { notifyTrackChange(); });
 
     mpris_handler->startEventLoop();
   }
@@ -371,6 +354,8 @@ public:
   }
 
   ~TUIMPRISIntegration() {
-    // Destructor handles cleanup automatically
+    if (queue_listener >= 0) {
+      queue->remove_listener(queue_listener);
+    }
   }
 };
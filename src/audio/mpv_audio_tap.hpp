@@ -0,0 +1,259 @@
+#pragma once
+
+#include "../common/paths.hpp"
+#include "audio_frame.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+// Visualizer input taken from mpv's own filter chain, so the bars follow
+// exactly what tuisic decodes and work with any ao, including ao=null.
+// libmpv has no client API for decoded PCM, so the analysis runs inside
+// mpv: an lavfi branch splits the audio into log-spaced constant-Q bands,
+// measures each band's RMS per block and prints it into a FIFO. A reader
+// thread parses that into band frames on the visualizer's ring.
+//
+// The tap must outlive the mpv handle: once the filter has opened the FIFO
+// it writes to it from mpv's audio thread until playback stops.
+class MpvAudioTap {
+public:
+  static constexpr int kBands = 64; // amerge takes at most 64 inputs
+  static constexpr int kBlock = 1024; // samples per measurement
+  static constexpr double LOW_CUTOFF = 50;
+  static constexpr double HIGH_CUTOFF = 10000;
+
+  explicit MpvAudioTap(std::shared_ptr<AudioFrameQueue> queue)
+      : frames(std::move(queue)) {}
+
+  ~MpvAudioTap() { stop(); }
+
+  MpvAudioTap(const MpvAudioTap &) = delete;
+  MpvAudioTap &operator=(const MpvAudioTap &) = delete;
+
+  // Creates the FIFO and starts reading; call before the filter is added
+  bool start() {
+    if (reader.joinable()) {
+      return true;
+    }
+    fifo_path = choose_path();
+    ::unlink(fifo_path.c_str());
+    if (::mkfifo(fifo_path.c_str(), 0600) != 0) {
+      error = "mkfifo " + fifo_path + ": " + std::strerror(errno);
+      return false;
+    }
+    // Non-blocking read end first so opening the write ends never blocks.
+    // The spare writer keeps the pipe from reporting EOF each time mpv
+    // rebuilds its filter chain between tracks.
+    read_fd = ::open(fifo_path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    hold_fd = read_fd < 0 ? -1
+                          : ::open(fifo_path.c_str(),
+                                   O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (read_fd < 0 || hold_fd < 0) {
+      error = "open " + fifo_path + ": " + std::strerror(errno);
+      stop();
+      return false;
+    }
+    stopping = false;
+    reader = std::thread([this] { read_loop(); });
+    return true;
+  }
+
+  // Suspended, the FIFO is still drained so mpv never blocks on it, but
+  // nothing is parsed or handed to the DSP thread
+  void set_suspended(bool value) { suspended = value; }
+
+  void stop() {
+    stopping = true;
+    if (hold_fd >= 0) {
+      // Wake a reader parked in poll() with no timeout
+      [[maybe_unused]] ssize_t ignored = ::write(hold_fd, "\n", 1);
+    }
+    if (reader.joinable()) {
+      reader.join();
+    }
+    for (int *fd : {&read_fd, &hold_fd}) {
+      if (*fd >= 0) {
+        ::close(*fd);
+        *fd = -1;
+      }
+    }
+    if (!fifo_path.empty()) {
+      ::unlink(fifo_path.c_str());
+    }
+  }
+
+  // Entry for mpv's "af" list, labelled so it can be removed by name
+  std::string mpv_filter() const {
+    std::string graph = filter_graph(fifo_path);
+    // %len% quoting keeps mpv's option parser out of the graph's brackets
+    return "@tuisic-tap:lavfi=graph=%" + std::to_string(graph.size()) + "%" +
+           graph;
+  }
+
+  const std::string &last_error() const { return error; }
+
+  // Passes the audio through untouched; a mono copy is split into bands,
+  // merged back as one channel per band and measured per block
+  static std::string filter_graph(const std::string &output) {
+    const double ratio = std::pow(HIGH_CUTOFF / LOW_CUTOFF, 1.0 / kBands);
+    const double q = 1.0 / (std::sqrt(ratio) - 1.0 / std::sqrt(ratio));
+
+    std::string split = "asplit=" + std::to_string(kBands);
+    std::string filters;
+    std::string merge;
+    for (int b = 0; b < kBands; ++b) {
+      std::string id = std::to_string(b);
+      double center = LOW_CUTOFF * std::pow(ratio, b + 0.5);
+      split += "[b" + id + "]";
+      filters += "[b" + id + "]bandpass=f=" + std::to_string(center) +
+                 ":width_type=q:width=" + std::to_string(q) + "[m" + id +
+                 "];";
+      merge += "[m" + id + "]";
+    }
+
+    return "asplit[play][tap];"
+           "[tap]aformat=sample_fmts=flt:channel_layouts=mono,"
+           "asetnsamples=n=" + std::to_string(kBlock) + "," + split + ";" +
+           filters + merge + "amerge=inputs=" + std::to_string(kBands) +
+           ",astats=metadata=1:reset=1:measure_perchannel=RMS_level:"
+           "measure_overall=none,"
+           "ametadata=mode=print:file=" + output + ",anullsink;"
+           "[play]anull";
+  }
+
+private:
+  // Band RMS from this far below full scale maps to 0, kRangeDb above to 1
+  static constexpr double kFloorDb = -70;
+  static constexpr double kRangeDb = 60;
+  static constexpr int kIdleMs = 100;
+  static constexpr int kIdleFrames = 20; // silent frames sent after audio stops
+  static constexpr size_t kMaxLine = 256;
+
+  std::shared_ptr<AudioFrameQueue> frames;
+  std::string fifo_path;
+  std::string error;
+  int read_fd = -1;
+  int hold_fd = -1;
+  std::atomic<bool> stopping{false};
+  std::atomic<bool> suspended{false};
+  std::thread reader;
+
+  // Reader-thread state: the block being assembled
+  std::array<float, kBands> pending{};
+  int pending_count = 0;
+  int idle_frames = kIdleFrames; // nothing to decay before the first block
+
+  // The path ends up inside a filter graph, so it must not contain any of
+  // lavfi's separators
+  static std::string choose_path() {
+    std::string name = "/visualizer-" + std::to_string(::getpid()) + ".fifo";
+    std::string dir = paths::get_cache_dir();
+    if (dir.find_first_of(":,;[]'\\ ") == std::string::npos) {
+      paths::ensure_directory_exists(dir);
+      return dir + name;
+    }
+    return "/tmp/tuisic-" + std::to_string(::getuid()) + name.substr(1);
+  }
+
+  void read_loop() {
+    char buffer[4096];
+    std::string line;
+    line.reserve(kMaxLine);
+
+    while (!stopping) {
+      // Once the bars have fallen, sleep until mpv writes again
+      pollfd fd{read_fd, POLLIN, 0};
+      int ready = ::poll(&fd, 1, idle_frames < kIdleFrames ? kIdleMs : -1);
+      if (ready < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      if (ready == 0) {
+        // Paused or between tracks: let the bars fall instead of freezing
+        if (idle_frames < kIdleFrames) {
+          idle_frames++;
+          pending.fill(0.0f);
+          emit();
+        }
+        continue;
+      }
+
+      ssize_t count = ::read(read_fd, buffer, sizeof(buffer));
+      if (count < 0) {
+        if (errno == EAGAIN || errno == EINTR) {
+          continue;
+        }
+        break;
+      }
+      if (suspended) {
+        idle_frames = kIdleFrames;
+        line.clear();
+        continue;
+      }
+      idle_frames = 0;
+      for (ssize_t i = 0; i < count; ++i) {
+        if (buffer[i] == '\n') {
+          parse_line(line);
+          line.clear();
+        } else if (line.size() < kMaxLine) {
+          line.push_back(buffer[i]);
+        }
+      }
+    }
+  }
+
+  // ametadata prints "frame:N pts:..." and then one key=value per line
+  void parse_line(const std::string &line) {
+    static constexpr char kPrefix[] = "lavfi.astats.";
+    static constexpr char kKey[] = ".RMS_level=";
+
+    if (line.compare(0, 6, "frame:") == 0) {
+      pending_count = 0; // a torn block from a rebuilt filter is dropped
+      return;
+    }
+    if (line.compare(0, sizeof(kPrefix) - 1, kPrefix) != 0) {
+      return;
+    }
+    const char *cursor = line.c_str() + sizeof(kPrefix) - 1;
+    char *end = nullptr;
+    long channel = std::strtol(cursor, &end, 10);
+    if (end == cursor || std::strncmp(end, kKey, sizeof(kKey) - 1) != 0 ||
+        channel < 1 || channel > kBands) {
+      return;
+    }
+    // "-inf" on digital silence parses to -infinity and clamps to 0
+    double db = std::strtod(end + sizeof(kKey) - 1, nullptr);
+    pending[channel - 1] = static_cast<float>(
+        std::clamp((db - kFloorDb) / kRangeDb, 0.0, 1.0));
+    if (++pending_count == kBands) {
+      emit();
+      pending_count = 0;
+    }
+  }
+
+  void emit() {
+    AudioFrame *frame = frames->write_slot();
+    if (!frame) {
+      frames->drop();
+      return;
+    }
+    std::copy(pending.begin(), pending.end(), frame->samples.begin());
+    frame->count = kBands;
+    frame->channels = 1;
+    frame->bands = kBands;
+    frames->commit();
+  }
+};
@@ -0,0 +1,253 @@
+#pragma once
+
+#include "../common/Track.h"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Tracks are shared, immutable handles: the queue, history and every
+// observer point at the same Track instead of copying it around.
+using TrackHandle = std::shared_ptr<const Track>;
+
+// The one play queue. The player drives it; the TUI, CLI, MPRIS and
+// Discord read from it and subscribe to changes instead of keeping their
+// own copies and indices.
+class PlayQueue {
+public:
+  using Listener = std::function<void()>;
+
+  static constexpr size_t kHistoryLimit = 200;
+
+  // Replace the queue and start at the given entry (in list order)
+  void replace(const std::vector<Track> &list, size_t start = 0) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tracks.clear();
+      tracks.reserve(list.size());
+      for (const auto &track : list) {
+        tracks.push_back(std::make_shared<const Track>(track));
+      }
+      rebuild_order_locked(std::min(start, tracks.empty() ? 0 : tracks.size() - 1));
+      record_history_locked();
+    }
+    notify();
+  }
+
+  void append(const std::vector<Track> &list) {
+    if (list.empty()) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t first = order.size();
+      for (const auto &track : list) {
+        order.push_back(tracks.size());
+        tracks.push_back(std::make_shared<const Track>(track));
+      }
+      if (shuffled) {
+        // Newcomers are shuffled among themselves; the planned order holds
+        std::shuffle(order.begin() + first, order.end(), rng);
+      }
+      reindex_locked(first);
+    }
+    notify();
+  }
+
+  // O(1) moves through the play order; return the new current track
+  TrackHandle next(bool wrap = true) {
+    return step_to([&] {
+      if (position + 1 < order.size()) {
+        position++;
+        return true;
+      }
+      if (wrap && !order.empty()) {
+        position = 0;
+        return true;
+      }
+      return false;
+    });
+  }
+
+  TrackHandle previous(bool wrap = true) {
+    return step_to([&] {
+      if (position > 0) {
+        position--;
+        return true;
+      }
+      if (wrap && !order.empty()) {
+        position = order.size() - 1;
+        return true;
+      }
+      return false;
+    });
+  }
+
+  // Jump to an entry by its list index (as shown in the UI)
+  TrackHandle jump(size_t index) {
+    return step_to([&] {
+      if (index >= tracks.size()) {
+        return false;
+      }
+      position = slot_of[index];
+      return true;
+    });
+  }
+
+  // Shuffle only permutes the play order; list indices stay put and the
+  // current track keeps playing
+  void set_shuffle(bool enabled) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (shuffled == enabled) {
+        return;
+      }
+      shuffled = enabled;
+      rebuild_order_locked(current_index_locked());
+    }
+    notify();
+  }
+
+  bool is_shuffled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return shuffled;
+  }
+
+  TrackHandle current() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return order.empty() ? nullptr : tracks[order[position]];
+  }
+
+  // List index of the current track, -1 when empty
+  int current_index() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return order.empty() ? -1 : static_cast<int>(current_index_locked());
+  }
+
+  // Tracks left after the current one in play order
+  size_t remaining() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return order.empty() ? 0 : order.size() - position - 1;
+  }
+
+  TrackHandle at(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return index < tracks.size() ? tracks[index] : nullptr;
+  }
+
+  // Cheap copy of the handles in list order
+  std::vector<TrackHandle> snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tracks;
+  }
+
+  std::vector<TrackHandle> history() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return {played.begin(), played.end()};
+  }
+
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tracks.size();
+  }
+
+  bool empty() const { return size() == 0; }
+
+  // Listeners run on the thread that changed the queue, outside the lock
+  int add_listener(Listener listener) {
+    std::lock_guard<std::mutex> lock(listener_mutex);
+    listeners[next_listener_id] = std::move(listener);
+    return next_listener_id++;
+  }
+
+  void remove_listener(int id) {
+    std::lock_guard<std::mutex> lock(listener_mutex);
+    listeners.erase(id);
+  }
+
+private:
+  mutable std::mutex mutex;
+  std::vector<TrackHandle> tracks; // list order, never reshuffled
+  std::vector<size_t> order;       // play order as indices into tracks
+  std::vector<size_t> slot_of;     // inverse of order, for O(1) jumps
+  size_t position = 0;             // index into order
+  bool shuffled = false;
+  std::deque<TrackHandle> played;
+  std::mt19937 rng{std::random_device{}()};
+
+  std::mutex listener_mutex;
+  std::map<int, Listener> listeners;
+  int next_listener_id = 0;
+
+  size_t current_index_locked() const {
+    return order.empty() ? 0 : order[position];
+  }
+
+  // Identity order, or a permutation with the given entry moved to the front
+  void rebuild_order_locked(size_t current) {
+    order.resize(tracks.size());
+    std::iota(order.begin(), order.end(), 0);
+    position = 0;
+    if (order.empty()) {
+      slot_of.clear();
+      return;
+    }
+    if (shuffled) {
+      std::swap(order[0], order[current]);
+      std::shuffle(order.begin() + 1, order.end(), rng);
+    } else {
+      position = current;
+    }
+    reindex_locked(0);
+  }
+
+  void reindex_locked(size_t from) {
+    slot_of.resize(order.size());
+    for (size_t i = from; i < order.size(); ++i) {
+      slot_of[order[i]] = i;
+    }
+  }
+
+  void record_history_locked() {
+    if (order.empty()) {
+      return;
+    }
+    played.push_back(tracks[order[position]]);
+    if (played.size() > kHistoryLimit) {
+      played.pop_front();
+    }
+  }
+
+  template <typename Fn> TrackHandle step_to(Fn &&step) {
+    TrackHandle handle;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!step()) {
+        return nullptr;
+      }
+      record_history_locked();
+      handle = tracks[order[position]];
+    }
+    notify();
+    return handle;
+  }
+
+  void notify() {
+    std::vector<Listener> to_call;
+    {
+      std::lock_guard<std::mutex> lock(listener_mutex);
+      for (const auto &[id, listener] : listeners) {
+        to_call.push_back(listener);
+      }
+    }
+    for (const auto &listener : to_call) {
+      listener();
+    }
+  }
+};
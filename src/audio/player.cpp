@@ -3,12 +3,34 @@
 #include "../common/Track.h"
 #include "../core/config/config.hpp"
 #include "../common/notification.hpp"
+#include "../common/executor.hpp"
+#include "../common/latency_tracker.hpp"
+#include "../common/idle_state.hpp"
+#include "../common/triple_buffer.hpp"
+#include "../common/simd.hpp"
+#include "bar_kernels.hpp"
 #include "lyrics_fetcher.hpp"
+#include "player_state.hpp"
+#include "play_queue.hpp"
+#include "command_scheduler.hpp"
+#include "buffer_profile.hpp"
+#include "../services/downloader/http_downloader.hpp"
+#ifdef WITH_VISUALIZER
+#include "audio_frame.hpp"
+#include "mpv_audio_tap.hpp"
 #ifdef WITH_CAVA
 #include "visualizer.hpp"
+using VisualizerBackend = AudioVisualizer;
+#else
+#include "spectrum_analyzer.hpp"
+using VisualizerBackend = SpectrumAnalyzer;
+#endif
+#ifdef WITH_PULSEAUDIO
 #include "audio_capture.hpp"
 #endif
+#endif
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cmath>
 #include <cstdlib>
@@ -29,13 +51,35 @@
 
 class MusicPlayer {
 private:
-#ifdef WITH_CAVA
-  std::shared_ptr<AudioVisualizer> visualizer;
+#ifdef WITH_VISUALIZER
+  std::shared_ptr<VisualizerBackend> visualizer;
+  // Declared ahead of the mpv handle so it is destroyed after it
+  std::unique_ptr<MpvAudioTap> audio_tap;
+#ifdef WITH_PULSEAUDIO
   std::shared_ptr<AudioCapture> audio_capture;
+  std::mutex capture_mutex; // start/stop come from playback and idle changes
 #endif
-  std::vector<double> audio_buffer;
-  std::function<void(const std::vector<double> &)> on_audio_data;
-  std::vector<double> visualization_data;  // Store processed visualization data
+  std::atomic_bool visualizer_started{false};
+  // Capture -> DSP: lock-free ring of preallocated frames
+  std::shared_ptr<AudioFrameQueue> audio_frames;
+  std::thread dsp_thread;
+  // DSP-thread scratch, sized for the largest bar count: per-bar targets,
+  // smoothed levels, last published
+  std::array<double, bars::kMax> bar_targets{};
+  std::array<double, bars::kMax> bar_levels{};
+  std::array<double, bars::kMax> bar_published{};
+  int active_bars = bars::kMin;
+#endif
+  // DSP -> renderer: latest smoothed bar levels (0..1), never blocks either
+  // side. The version only moves when the bars visibly changed.
+  TripleBuffer<std::vector<double>> visualization_data;
+  std::atomic<uint64_t> visualization_version{0};
+  // Renderer -> other threads (the control socket): a copy of the bars the
+  // renderer last picked up. Set once something owns the read side.
+  std::shared_ptr<const std::vector<double>> visualization_snapshot;
+  std::atomic_bool render_reader{false};
+  // Bar count the pane has room for; the DSP thread follows it
+  std::atomic<int> requested_bars{bars::kMin};
 
 
   // Smart pointer with custom deleter for mpv handle
@@ -47,31 +91,33 @@ private:
 
   // Atomic flags for thread-safe state management
   std::atomic_bool running{true};
-  std::atomic_bool is_playing{false};
-  std::atomic_bool is_paused{false};
-  std::atomic_bool is_loaded{false};
-
-  // Atomic properties with thread-safe access
-  std::atomic<double> current_position{0.0};
-  std::atomic<double> duration{0.0};
   std::atomic_bool is_downloading{false};
 
+  // Published playback state; every reader-facing getter goes through this
+  PlayerStatePublisher state;
+
+  // Seeks and volume changes are merged here and sent by the event thread
+  CommandScheduler commands;
+
+  // Only set when player.buffer_profile is "adaptive"
+  std::unique_ptr<AdaptiveBuffer> adaptive_buffer;
+
+  // Suspends ticks and visualizer work while idle; declared after
+  // everything its listener touches so it is dropped first
+  idle::Subscription idle_subscription;
+
   // Mutex for thread-safe operations
   mutable std::mutex player_mutex;
 
-  // Playlist management
-  std::vector<std::string> playlist;
-  std::atomic<int> current_playlist_index{-1};
+  // Shared play queue; the player loads whatever it points at
+  std::shared_ptr<PlayQueue> queue = std::make_shared<PlayQueue>();
 
-  // Subtitle management - changed to avoid atomic<shared_ptr>
-  std::string current_subtitle{""};
   std::atomic_bool subtitles_enabled{true}; // Toggle for showing/hiding subtitles
 
   // Lyrics management
   std::unique_ptr<tuisic::LyricsFetcher> lyrics_fetcher;
   std::vector<tuisic::LyricLine> current_lyrics;
   std::atomic_bool has_lyrics{false};
-  std::atomic_bool fetching_lyrics{false};
 
   // Callbacks
   std::function<void()> on_state_change;
@@ -79,10 +125,6 @@ private:
   std::function<void()> on_end_of_track_callback;
   std::function<void(const std::string &)> on_subtitle_change;
 
-  // Current track data for navigation
-  std::vector<Track> current_track_data;
-  int current_track_index = -1;
-
   std::string current_url;
 
   // Logging utility
@@ -105,7 +147,11 @@ private:
   }
 
 public:
-  MusicPlayer() : lyrics_fetcher(std::make_unique<tuisic::LyricsFetcher>()) {
+  MusicPlayer() : MusicPlayer(std::make_shared<Config>()) {}
+
+  explicit MusicPlayer(std::shared_ptr<Config> cfg)
+      : config(std::move(cfg)),
+        lyrics_fetcher(std::make_unique<tuisic::LyricsFetcher>()) {
     // Create MPV handle with error checking
     mpv.reset(mpv_create());
     if (!mpv) {
@@ -113,62 +159,53 @@ public:
       throw std::runtime_error("MPV initialization failed");
     }
 
-    // Configure MPV options from config
-    const std::vector<std::pair<std::string, std::string>> mpv_options = {
+    // Defaults first, then player.mpv_options from the config on top
+    std::vector<std::pair<std::string, std::string>> mpv_options = {
         {"video", "no"},
-        {"audio-display", "no"}, 
+        {"audio-display", "no"},
         {"terminal", "no"},
-        {"quiet", "yes"}, 
-        {"sub-auto", "fuzzy"},   
-        {"sub-codepage", "UTF-8"}
+        {"quiet", "yes"},
+        {"sub-auto", "fuzzy"},
+        {"sub-codepage", "UTF-8"},
+        {"ao", config->get_audio_output()}
     };
+    for (auto &option : config->get_mpv_options()) {
+      mpv_options.push_back(std::move(option));
+    }
+
+    // Buffering profile; explicit mpv_options above still win
+    std::string profile_name = config->get_buffer_profile();
+    BufferProfile profile = BufferProfile::from_name(profile_name);
+    if (profile_name == "adaptive") {
+      adaptive_buffer = std::make_unique<AdaptiveBuffer>(profile);
+    }
+    auto profile_options = profile.mpv_options();
+    mpv_options.insert(mpv_options.begin(), profile_options.begin(),
+                       profile_options.end());
 
-    for (const auto &[option, default_value] : mpv_options) {
-      // For now use defaults, but this allows easy config integration later
-      if (mpv_set_option_string(mpv.get(), option.c_str(), default_value.c_str()) < 0) {
+    for (const auto &[option, value] : mpv_options) {
+      if (mpv_set_option_string(mpv.get(), option.c_str(), value.c_str()) < 0) {
         log_error("Failed to set option: " + option);
       }
     }
 
-#ifdef WITH_CAVA
+#ifdef WITH_VISUALIZER
     try {
-      visualizer = std::make_shared<AudioVisualizer>();
-      audio_capture = std::make_shared<AudioCapture>();
-
-      // Set up audio capture callback
-      audio_capture->set_callback([this](const std::vector<double>& audio_data) {
-        static int callback_count = 0;
-        callback_count++;
-
-        if (callback_count == 1) {
-          std::cout << "[Player] Audio capture callback working! Received "
-                    << audio_data.size() << " samples" << std::endl;
-        }
-
-        if (visualizer && on_audio_data) {
-          // Process through visualizer
-          std::vector<double> viz_data;
-          {
-            std::lock_guard<std::mutex> lock(player_mutex);
-            viz_data = visualizer->process(audio_data);
-            visualization_data = viz_data;
-          }
-
-          if (callback_count % 100 == 0) {
-            std::cout << "[Player] Processed " << callback_count
-                      << " buffers, viz_data size: " << viz_data.size() << std::endl;
-          }
+      visualizer = std::make_shared<VisualizerBackend>();
+      audio_frames = std::make_shared<AudioFrameQueue>();
+      std::string source = config->get_visualizer_source();
+#ifdef WITH_PULSEAUDIO
+      if (source == "pulse") {
+        audio_capture = std::make_shared<AudioCapture>();
+        audio_capture->set_output(audio_frames);
+      }
+#endif
+      if (source == "mpv" || (source == "pulse" && !has_visualizer())) {
+        start_audio_tap();
+      }
 
-          // Send to UI callback
-          if (!viz_data.empty()) {
-            on_audio_data(viz_data);
-          }
-        } else {
-          if (callback_count == 1) {
-            std::cerr << "[Player] Visualizer or on_audio_data callback missing!" << std::endl;
-          }
-        }
-      });
+      active_bars = visualizer->get_num_bars();
+      visualization_data.reset(std::vector<double>(active_bars, 0.0));
 
     } catch (const std::exception& e) {
       log_error(std::string("Failed to initialize visualizer: ") + e.what());
@@ -179,61 +216,69 @@ public:
     mpv_observe_property(mpv.get(), 0, "time-pos", MPV_FORMAT_DOUBLE);
     mpv_observe_property(mpv.get(), 0, "duration", MPV_FORMAT_DOUBLE);
     mpv_observe_property(mpv.get(), 0, "sub-text", MPV_FORMAT_STRING);
-    // Set audio output based on platform
-#ifdef _WIN32
-    mpv_set_option_string(mpv.get(), "ao", "wasapi");
-#elif defined(__APPLE__)
-    mpv_set_option_string(mpv.get(), "ao", "coreaudio");
-#else
-    mpv_set_option_string(mpv.get(), "ao", "pulse");
-#endif
-
+    mpv_observe_property(mpv.get(), 0, "volume", MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv.get(), 0, "pause", MPV_FORMAT_FLAG);
+    mpv_observe_property(mpv.get(), 0, "idle-active", MPV_FORMAT_FLAG);
+    if (adaptive_buffer) {
+      mpv_observe_property(mpv.get(), 0, "cache-speed", MPV_FORMAT_DOUBLE);
+      mpv_observe_property(mpv.get(), 0, "audio-bitrate", MPV_FORMAT_DOUBLE);
+      mpv_observe_property(mpv.get(), 0, "paused-for-cache", MPV_FORMAT_FLAG);
+    }
 
     mpv_set_property_string(mpv.get(), "sid", "1");
     mpv_request_event(mpv.get(), MPV_EVENT_TICK, true);
 
+    // Hooks run in ascending priority and ytdl_hook sits at 10, so this
+    // fires once the stream URL has been resolved
+    mpv_hook_add(mpv.get(), 0, "on_load", 50);
+
     // Initialize MPV
     if (mpv_initialize(mpv.get()) < 0) {
       log_error("MPV initialization failed");
       throw std::runtime_error("MPV initialization failed");
     }
 
+    // Nothing is loaded yet; "idle-active" reports changes from here on
+    idle::coordinator().set(idle::Stopped, true);
+    idle_subscription = idle::coordinator().subscribe(
+        [this](bool idle) { on_idle_changed(idle); });
+
     // Start event handling thread
     event_thread = std::make_unique<std::thread>([this] { event_loop(); });
   }
 
-  /* MusicPlayer(std::shared_ptr<Config> cfg) : config(cfg) { */
-  /*   set_volume(config->get_volume()); */
-
-  /* } */
-
   // Destructor with RAII principles
   ~MusicPlayer() {
     running = false;
     if (event_thread && event_thread->joinable()) {
       event_thread->join();
     }
-  }
-
-  void set_audio_callback(
-      std::function<void(const std::vector<double> &)> callback) {
-    on_audio_data = std::move(callback);
+    idle_subscription.reset();
+#ifdef WITH_VISUALIZER
+#ifdef WITH_PULSEAUDIO
+    if (audio_capture) {
+      audio_capture->stop();
+    }
+#endif
+    if (audio_frames) {
+      audio_frames->interrupt();
+    }
+    if (dsp_thread.joinable()) {
+      dsp_thread.join();
+    }
+#endif
   }
 
   // Subtitle management methods
   void update_subtitle(const char *new_subtitle) {
-    std::lock_guard<std::mutex> lock(player_mutex); // Thread-safe update
-
     // Only update if subtitles are enabled
-    if (subtitles_enabled) {
-      current_subtitle = new_subtitle ? new_subtitle : "";
-    } else {
-      current_subtitle = "";
-    }
+    std::string text = subtitles_enabled && new_subtitle ? new_subtitle : "";
+    state.update([&text](PlayerState &s) { s.subtitle = text; });
 
+    std::lock_guard<std::mutex> lock(player_mutex);
     if (on_subtitle_change) {
       try {
-        on_subtitle_change(current_subtitle);
+        on_subtitle_change(text);
       } catch (const std::exception &e) {
         log_error("Subtitle callback failed: " + std::string(e.what()));
       }
@@ -245,11 +290,11 @@ public:
 
     // Clear subtitle immediately when disabling
     if (!subtitles_enabled) {
+      state.update([](PlayerState &s) { s.subtitle.clear(); });
       std::lock_guard<std::mutex> lock(player_mutex);
-      current_subtitle = "";
       if (on_subtitle_change) {
         try {
-          on_subtitle_change(current_subtitle);
+          on_subtitle_change("");
         } catch (const std::exception &e) {
           log_error("Subtitle callback failed: " + std::string(e.what()));
         }
@@ -265,21 +310,22 @@ public:
 
   // Fetch lyrics asynchronously for the current track
   void fetch_lyrics_async() {
-    if (current_track_index < 0 || current_track_index >= current_track_data.size()) {
+    auto now_playing = state.load()->track;
+    if (!now_playing) {
       return;
     }
 
-    if (fetching_lyrics.exchange(true)) {
-      return; // Already fetching
-    }
-
     // Get track info
-    Track current_track = current_track_data[current_track_index];
+    Track current_track = *now_playing;
 
-    // Fetch in a separate thread to avoid blocking
-    std::thread([this, current_track]() {
+    // A newer track supersedes a lookup still in flight
+    tasks::shared().submit_latest(tasks::Lane::Prefetch, "lyrics",
+                                  [this, current_track](const tasks::CancelToken &token) {
       try {
         auto lyrics_opt = lyrics_fetcher->fetch_lyrics(current_track.artist, current_track.name);
+        if (token.cancelled()) {
+          return;
+        }
 
         if (lyrics_opt.has_value()) {
           auto parsed_lyrics = lyrics_fetcher->parse_lrc(lyrics_opt.value());
@@ -299,95 +345,42 @@ public:
       } catch (const std::exception& e) {
         log_error("Lyrics fetch error: " + std::string(e.what()));
       }
-
-      fetching_lyrics = false;
-    }).detach();
-  }
-
-  std::string get_current_subtitle() const {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    return current_subtitle;
-  }
-
-  // Track navigation methods
-  void previous_track(const std::vector<Track> &track_data,
-                      int &current_index) {
-    if (track_data.empty())
-      return;
-
-    // Update track data and current track index
-    current_track_data = track_data;
-    current_track_index = current_index;
-
-    // Circular previous
-    current_index = (current_index - 1 + track_data.size()) % track_data.size();
-    play(track_data[current_index].url);
+    });
   }
 
-  void next_track(const std::vector<Track> &track_data, int &current_index) {
-    if (track_data.empty())
-      return;
+  std::string get_current_subtitle() const { return state.load()->subtitle; }
 
-    // Update track data and current track index
-    current_track_data = track_data;
-    current_track_index = current_index;
-    current_index = (current_index) % track_data.size();
-    play(track_data[current_index].url);
-  }
+  std::shared_ptr<PlayQueue> get_queue() const { return queue; }
 
-  void create_playlist(const std::vector<std::string> &urls) {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    if (urls.empty()) {
-      log_error("No URLs provided for playlist");
+  // Replace the queue and start playing from the given entry
+  void load_queue(const std::vector<Track> &tracks, size_t start = 0) {
+    if (tracks.empty()) {
+      log_error("No tracks provided for playlist");
       return;
     }
-    // Clear and swap playlist
-    playlist.clear();
-    // playlist.swap(const_cast<std::vector<std::string> &>(urls));
-    current_playlist_index = 0;
-    playlist = urls;
-    mpv_command_string(mpv.get(), "playlist-clear");
-    if (!playlist.empty()) {
-      const char *cmd[] = {"loadfile", playlist[0].c_str(), NULL};
-      int result = mpv_command(mpv.get(), cmd);
-      if (result < 0) {
-        // std::cerr << "Failed to load first track. Error code: " << result
-        //           << std::endl;
-          notifications::send("Failed to load first track. Error code: " + std::to_string(result));
-        return;
-      }
-    }
+    queue->replace(tracks, start);
+    play_current();
   }
 
-  void shuffle_playlist() {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    if (playlist.size() > 1) {
-      std::random_device rd;
-      std::mt19937 g(rd());
-      std::shuffle(playlist.begin(), playlist.end(), g);
-      current_playlist_index = 0;
+  void shuffle_queue(bool enabled) { queue->set_shuffle(enabled); }
+
+  // Queue navigation; each step is O(1) and copies no track data
+  void next_track() {
+    if (queue->next()) {
+      play_current();
     }
   }
 
-  void play_playlist() {
-    if (playlist.empty())
-      return;
-
-    if (current_playlist_index == -1) {
-      current_playlist_index = 0;
+  void previous_track() {
+    if (queue->previous()) {
+      play_current();
     }
-    play(playlist[current_playlist_index]);
   }
 
-  void next_track() {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    if (playlist.empty())
-      return;
-
-    current_playlist_index = (current_playlist_index + 1) % playlist.size();
-    const char *cmd[] = {"loadfile", playlist[current_playlist_index].c_str(),
-                         NULL};
-    mpv_command(mpv.get(), cmd);
+  void jump_to(size_t index) {
+    if (queue->jump(index)) {
+      play_current();
+    }
   }
 
   void play(const std::string &url) {
@@ -396,185 +389,157 @@ public:
       const char *cmd[] = {"loadfile", url.c_str(), NULL};
       mpv_command_async(mpv.get(), 0, cmd);
       current_url = url;
-      is_loaded = true;
-      is_playing = true;
+      commands.reset();
+      state.update([&url](PlayerState &s) {
+        s.url = url;
+        s.loaded = true;
+        // Drop stale metadata when played by bare URL
+        if (s.track && s.track->url != url) {
+          s.track.reset();
+        }
+      });
 
-#ifdef WITH_CAVA
+#ifdef WITH_VISUALIZER
       // Start audio capture when playback begins
-      if (audio_capture) {
-        audio_capture->start();
-      }
+      start_visualizer();
 #endif
     }
 
     // If paused, unpause
-    if (is_paused) {
-      const char *cmd[] = {"cycle", "pause", NULL};
-      mpv_command_async(mpv.get(), 0, cmd);
-      is_paused = false;
+    if (state.load()->paused) {
+      set_paused(false);
 
-#ifdef WITH_CAVA
+#ifdef WITH_VISUALIZER
       // Resume audio capture
-      if (audio_capture) {
-        audio_capture->start();
-      }
+      start_visualizer();
 #endif
     }
   }
 
-  // Overload that accepts Track object for lyrics support
-  void play(const Track &track) {
-    {
-      std::lock_guard<std::mutex> lock(player_mutex);
-      // Update current track data for lyrics fetching
-      current_track_data.clear();
-      current_track_data.push_back(track);
-      current_track_index = 0;
-    }
-    // Call the regular play method
-    play(track.url);
-  }
+  // A single track becomes a queue of one
+  void play(const Track &track) { load_queue({track}); }
 
   void pause() {
     std::lock_guard<std::mutex> lock(player_mutex);
-    if (is_loaded) {
-      const char *cmd[] = {"cycle", "pause", NULL};
-      mpv_command_async(mpv.get(), 0, cmd);
-      is_paused = !is_paused;
+    auto current = state.load();
+    if (current->loaded) {
+      set_paused(!current->paused);
     }
   }
 
   void resume() {
     std::lock_guard<std::mutex> lock(player_mutex);
-    if (is_paused) {
-      const char *cmd[] = {"cycle", "pause", NULL};
-      mpv_command_async(mpv.get(), 0, cmd);
-      is_paused = false;
+    if (state.load()->paused) {
+      set_paused(false);
     }
   }
 
   void togglePlayPause() {
     std::lock_guard<std::mutex> lock(player_mutex);
-    if (is_paused) {
-      const char *cmd[] = {"cycle", "pause", NULL};
-      mpv_command_async(mpv.get(), 0, cmd);
-      is_paused = false;
-    } else {
-      const char *cmd[] = {"cycle", "pause", NULL};
-      mpv_command_async(mpv.get(), 0, cmd);
-      is_paused = !is_paused;
-    }
-
+    set_paused(!state.load()->paused);
   }
 
-  std::string get_current_track() const {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    return current_url;
-  }
-  
+  std::string get_current_track() const { return state.load()->url; }
+
   std::string get_current_track_data() const {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    return current_track_data[current_track_index].id;
+    auto current = state.load();
+    return current->track ? current->track->id : "";
   }
 
+  // Consistent view of the whole player in one atomic load
+  std::shared_ptr<const PlayerState> get_state() const { return state.load(); }
+
   void seek(double position) {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    std::string pos = std::to_string(position);
-    const char *cmd[] = {"seek", pos.c_str(), "absolute", NULL};
-    mpv_command_async(mpv.get(), 0, cmd);
+    commands.seek_absolute(position, state.load()->duration);
+    mpv_wakeup(mpv.get());
   }
 
   void skip_forward() {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    const char *cmd[] = {"seek", "5", "relative", NULL};
-    mpv_command_async(mpv.get(), 0, cmd);
+    auto current = state.load();
+    commands.seek_relative(5, state.position(), current->duration);
+    mpv_wakeup(mpv.get());
   }
 
   void skip_backward() {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    const char *cmd[] = {"seek", "-5", "relative", NULL};
-    mpv_command_async(mpv.get(), 0, cmd);
+    auto current = state.load();
+    commands.seek_relative(-5, state.position(), current->duration);
+    mpv_wakeup(mpv.get());
   }
 
   void stop() {
     std::lock_guard<std::mutex> lock(player_mutex);
     const char *cmd[] = {"stop", NULL};
     mpv_command_async(mpv.get(), 0, cmd);
-    is_loaded = false;
-    is_playing = false;
-    is_paused = false;
-    current_playlist_index = -1;
+    state.update([](PlayerState &s) {
+      s.loaded = false;
+      s.paused = false;
+      s.playlist_index = -1;
+    });
   }
 
+  // filename is the base name without extension; the extension follows the
+  // downloaded codec so nothing is re-encoded
   bool download_track(const std::string &url, const std::string path,
                       const std::string &filename) {
     std::lock_guard<std::mutex> lock(player_mutex);
-    /* std::string final_path = config->get_download_path(); */
-
-    std::string final_path = path + "/" + filename;
-    /* std::string final_path = "/home/dk/Music/" + filename; */
 
     if (is_downloading) {
       log_error("Already another download in progress");
       return false;
     }
 
-    // Start download in a separate thread
-    std::thread download_thread([this, url, final_path]() {
-      is_downloading = true;
+    is_downloading = true;
+
+    // Downloads run on the background lane so they never delay playback work
+    bool queued = tasks::shared().submit(tasks::Lane::Background,
+                                         [this, url, path, filename](const tasks::CancelToken &) {
 
       try {
-        // Construct yt-dlp command
-        // -x: Extract audio
-        // --audio-format mp3: Convert to MP3
-        // -o: Output template
-        std::string command = "yt-dlp -q -x --audio-format mp3 -o \"" +
-                              final_path + "\" \"" + url + "\"";
-
-        /* std::string command = */
-        /*     fmt::format("yt-dlp -x --audio-format {} -o \"{}\" \"{}\"", */
-        /*                 config->get_download_format(), final_path, url); */
-
-        // Execute the command
-        int result = system(command.c_str());
-
-        if (result != 0) {
-          throw std::runtime_error("yt-dlp failed to download the track");
-        }
+        if (HttpDownloader::is_direct_media_url(url)) {
+          // Direct media link: fetch it in-process, no yt-dlp round trip
+          HttpDownloader downloader;
+          auto result = downloader.download(url, path, filename);
+          if (!result.ok) {
+            throw std::runtime_error(result.error);
+          }
+          notifications::send_download_complete("" + result.path);
+        } else {
+          // Page URL that needs resolving: let yt-dlp extract the best
+          // audio stream and keep its original codec
+          // -x: Extract audio
+          // -o: Output template, extension picked by yt-dlp
+          std::string output = path + "/" + filename + ".%(ext)s";
+          std::string command =
+              "yt-dlp -q -x -o \"" + output + "\" \"" + url + "\"";
+
+          // Execute the command
+          int result = system(command.c_str());
+
+          if (result != 0) {
+            throw std::runtime_error("yt-dlp failed to download the track");
+          }
 
-        // Notify completion
-        // system(("notify-send \"Download completed: " + final_path + "\"").c_str());
-        notifications::send_download_complete("" + final_path);
+          // Notify completion
+          notifications::send_download_complete("" + path + "/" + filename);
+        }
 
       } catch (const std::exception &e) {
         log_error(e.what());
-        // system(
-        //     ("notify-send \"Download failed: " + std::string(e.what()) + "\"")
-        //         .c_str());
         notifications::send_download_failed("" + std::string(e.what()));
       }
 
       is_downloading = false;
     });
 
-    download_thread.detach();
-
-    return true;
+    if (!queued) {
+      is_downloading = false;
+      log_error("Download queue is full");
+    }
+    return queued;
   }
 
   bool is_download_in_progress() const { return is_downloading; }
 
-  void on_track_end() {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    current_playlist_index++;
-    if (current_playlist_index < playlist.size()) {
-      // Play next track
-      const char *cmd[] = {"loadfile", playlist[current_playlist_index].c_str(),
-                           NULL};
-      mpv_command(mpv.get(), cmd);
-    }
-  }
-
   void toggle_repeat() {
     std::lock_guard<std::mutex> lock(player_mutex);
     const char *cmd[] = {"cycle", "repeat", NULL};
@@ -582,27 +547,83 @@ public:
   }
 
   int get_current_playlist_index() const {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    return current_playlist_index;
+    return state.load()->playlist_index;
   }
 
   void set_volume(int volume) {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    int64_t mpv_volume = std::clamp(volume, 0, 100);
-    mpv_set_property_async(mpv.get(), 0, "volume", MPV_FORMAT_INT64,
-                           &mpv_volume);
+    volume = std::clamp(volume, 0, 100);
+    commands.set_volume(volume);
+    // Show the new level right away; the observed property confirms it
+    state.update([volume](PlayerState &s) { s.volume = volume; });
+    mpv_wakeup(mpv.get());
+  }
+
+  // Observed from mpv, so this never round-trips to the core
+  int get_volume() const { return state.load()->volume; }
+
+  // Whether bars can be shown at all: a DSP backend and an audio source
+  bool has_visualizer() const {
+#if defined(WITH_VISUALIZER) && defined(WITH_PULSEAUDIO)
+    return visualizer && (audio_tap || audio_capture);
+#elif defined(WITH_VISUALIZER)
+    return visualizer && audio_tap;
+#else
+    return false;
+#endif
   }
 
-  int get_volume() const {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    int64_t volume = 100;
-    mpv_get_property(mpv.get(), "volume", MPV_FORMAT_INT64, &volume);
-    return static_cast<int>(volume);
+  // Where the bars come from: "mpv", "pulse" or "none"
+  std::string get_visualizer_source() const {
+#ifdef WITH_VISUALIZER
+    if (visualizer && audio_tap) {
+      return "mpv";
+    }
+#ifdef WITH_PULSEAUDIO
+    if (visualizer && audio_capture) {
+      return "pulse";
+    }
+#endif
+#endif
+    return "none";
   }
 
-  std::vector<double> get_visualization_data() const {
-    std::lock_guard<std::mutex> lock(player_mutex);
-    return visualization_data;
+  // Called by the pane with the number of bars that fit its width; snapped
+  // to a supported count
+  void set_visualizer_bars(int count) {
+    requested_bars.store(bars::snap(count), std::memory_order_relaxed);
+  }
+
+  // Bumped by the DSP thread on every visible change; cheap to poll
+  uint64_t get_visualization_version() const {
+    return visualization_version.load(std::memory_order_acquire);
+  }
+
+  // Newest smoothed bar levels in 0..1. Single reader: call from the render
+  // thread only.
+  const std::vector<double> &get_visualization_data() {
+    if (visualization_data.update()) {
+      std::atomic_store(&visualization_snapshot,
+                        std::make_shared<const std::vector<double>>(
+                            visualization_data.read_buffer()));
+    }
+    return visualization_data.read_buffer();
+  }
+
+  // Declares that a render thread reads the bars. Call before anything
+  // else can ask for a snapshot (the control server starting).
+  void claim_visualization_reader() {
+    render_reader.store(true, std::memory_order_release);
+  }
+
+  // Bar levels for any other thread. With a render thread this is what it
+  // last picked up; in the headless modes, where nothing draws, the one
+  // caller is the reader itself and takes the newest levels.
+  std::shared_ptr<const std::vector<double>> get_visualization_snapshot() {
+    if (!render_reader.load(std::memory_order_acquire)) {
+      get_visualization_data();
+    }
+    auto snapshot = std::atomic_load(&visualization_snapshot);
+    return snapshot ? snapshot : std::make_shared<const std::vector<double>>();
   }
 
   // Callback setters
@@ -630,9 +651,200 @@ public:
   }
 
 private:
+  // Load the queue's current entry
+  void play_current() {
+    TrackHandle track = queue->current();
+    if (!track) {
+      return;
+    }
+    int index = queue->current_index();
+    state.update([&track, index](PlayerState &s) {
+      s.track = track;
+      s.playlist_index = index;
+    });
+    {
+      // Always reload, even when the next entry is the same URL
+      std::lock_guard<std::mutex> lock(player_mutex);
+      current_url.clear();
+    }
+    play(track->url);
+  }
+
+  // Optimistic update; the observed "pause" property confirms it
+  void set_paused(bool paused) {
+    int flag = paused ? 1 : 0;
+    mpv_set_property_async(mpv.get(), 0, "pause", MPV_FORMAT_FLAG, &flag);
+    state.update([paused](PlayerState &s) { s.paused = paused; });
+    idle::coordinator().set(idle::Paused, paused);
+  }
+
+#ifdef WITH_VISUALIZER
+  // Adds the analysis branch to mpv's filter chain; before mpv_initialize,
+  // on top of any "af" from player.mpv_options
+  void start_audio_tap() {
+    audio_tap = std::make_unique<MpvAudioTap>(audio_frames);
+    if (!audio_tap->start()) {
+      log_error("Visualizer tap unavailable: " + audio_tap->last_error());
+      audio_tap.reset();
+      return;
+    }
+    std::string filters = config->get_mpv_option("af");
+    if (!filters.empty()) {
+      filters += ",";
+    }
+    filters += audio_tap->mpv_filter();
+    if (mpv_set_option_string(mpv.get(), "af", filters.c_str()) < 0) {
+      log_error("Failed to set option: af");
+      audio_tap.reset();
+    }
+  }
+
+  // Capture and DSP start with the first playback
+  void start_visualizer() {
+    if (!has_visualizer()) {
+      return;
+    }
+    visualizer_started = true;
+    request_capture_sync();
+    if (!dsp_thread.joinable()) {
+      dsp_thread = std::thread([this] { dsp_loop(); });
+    }
+  }
+
+  // Starting capture connects to PulseAudio and stopping joins its thread,
+  // so neither runs on the caller (the UI thread, or under player_mutex or
+  // the idle coordinator's lock). The job reads the state it finds when it
+  // runs, so only the latest request matters.
+  void request_capture_sync() {
+#ifdef WITH_PULSEAUDIO
+    if (audio_capture) {
+      tasks::shared().submit_latest(tasks::Lane::Prefetch, "capture",
+                                    [this](const tasks::CancelToken &) {
+                                      sync_capture();
+                                    });
+    }
+#endif
+  }
+
+  // Monitor capture runs only while started and not idle
+  void sync_capture() {
+#ifdef WITH_PULSEAUDIO
+    std::lock_guard<std::mutex> lock(capture_mutex);
+    if (!audio_capture) {
+      return;
+    }
+    if (visualizer_started && !idle::coordinator().is_idle()) {
+      audio_capture->start();
+    } else {
+      audio_capture->stop();
+    }
+#endif
+  }
+
+  // Follow the pane's bar count; returns whether it changed
+  bool resize_bars() {
+    int wanted = requested_bars.load(std::memory_order_relaxed);
+    if (wanted == active_bars) {
+      return false;
+    }
+    try {
+      visualizer->set_num_bars(wanted);
+    } catch (const std::exception &e) {
+      log_error(std::string("Visualizer resize failed: ") + e.what());
+    }
+    // Either way, stop asking for a count the backend didn't take
+    active_bars = visualizer->get_num_bars();
+    requested_bars.store(active_bars, std::memory_order_relaxed);
+    bar_levels.fill(0.0);
+    bar_published.fill(0.0);
+    return true;
+  }
+
+  // Drains captured frames, smooths and publishes bars; never touches
+  // player_mutex
+  void dsp_loop() {
+    // Fast rise, slow fall (gravity), per captured frame
+    constexpr double kRise = 0.3;
+    constexpr double kFall = 0.1;
+    constexpr double kSensitivity = 1.2;
+    // Smaller moves than this are invisible at terminal resolution
+    constexpr double kEpsilon = 1e-3;
+
+    while (running) {
+      // Idle sources send nothing; the long wait only bounds a missed poke
+      auto timeout = idle::coordinator().is_idle()
+                         ? std::chrono::milliseconds(1000)
+                         : std::chrono::milliseconds(50);
+      if (!audio_frames->wait(timeout)) {
+        continue;
+      }
+      while (const AudioFrame *frame = audio_frames->read_slot()) {
+        idle::coordinator().count(idle::Wakeup::AudioFrame);
+        bool resized = resize_bars();
+
+        bool changed = resized;
+        const int n = active_bars;
+        if (frame->bands > 0) {
+          // The mpv tap already did the analysis
+          bars::regroup(n, frame->samples.data(), frame->bands,
+                        bar_targets.data(), kSensitivity);
+        } else {
+          const auto &raw =
+              visualizer->process(frame->samples.data(), frame->count);
+          bars::fold(n, raw.data(), raw.size(), bar_targets.data(),
+                     kSensitivity);
+        }
+        simd::smooth(bar_levels.data(), bar_targets.data(), n, kRise, kFall);
+        for (int i = 0; i < n && !changed; ++i) {
+          changed = std::abs(bar_levels[i] - bar_published[i]) > kEpsilon;
+        }
+        audio_frames->release();
+        if (!changed) {
+          continue;
+        }
+        std::copy_n(bar_levels.begin(), active_bars, bar_published.begin());
+
+        // Only reallocates right after the bar count grows
+        auto &out = visualization_data.write_buffer();
+        out.assign(bar_levels.begin(), bar_levels.begin() + active_bars);
+        visualization_data.publish();
+        visualization_version.fetch_add(1, std::memory_order_release);
+      }
+    }
+  }
+#endif
+
+  // Runs under the idle coordinator's lock; only flips switches
+  void on_idle_changed(bool idle) {
+    // Lyric/subtitle polling; the UI catches up on the next redraw
+    mpv_request_event(mpv.get(), MPV_EVENT_TICK, !idle);
+#ifdef WITH_VISUALIZER
+    if (audio_tap) {
+      audio_tap->set_suspended(idle);
+    }
+    request_capture_sync();
+#endif
+  }
+
+  // Send whatever the scheduler has let through since the last wakeup
+  void dispatch_commands() {
+    auto batch = commands.take_due();
+    if (batch.seek_to) {
+      std::string pos = std::to_string(*batch.seek_to);
+      const char *cmd[] = {"seek", pos.c_str(), "absolute", NULL};
+      mpv_command_async(mpv.get(), 0, cmd);
+    }
+    if (batch.volume) {
+      int64_t mpv_volume = *batch.volume;
+      mpv_set_property_async(mpv.get(), 0, "volume", MPV_FORMAT_INT64,
+                             &mpv_volume);
+    }
+  }
+
   void event_loop() {
     while (running) {
-      mpv_event *event = mpv_wait_event(mpv.get(), 0.1);
+      dispatch_commands();
+      mpv_event *event = mpv_wait_event(mpv.get(), commands.wait_timeout(0.1));
       if (event->event_id == MPV_EVENT_NONE) {
         continue;
       }
@@ -643,6 +855,15 @@ private:
         handle_property_change(prop);
         break;
       }
+      case MPV_EVENT_START_FILE:
+        latency::tracker().mark(latency::Stage::Loadfile);
+        break;
+      case MPV_EVENT_HOOK: {
+        auto *hook = static_cast<mpv_event_hook *>(event->data);
+        latency::tracker().mark(latency::Stage::YtdlHook);
+        mpv_hook_continue(mpv.get(), hook->id);
+        break;
+      }
       case MPV_EVENT_PLAYBACK_RESTART:
         handle_playback_restart();
         break;
@@ -653,6 +874,7 @@ private:
         handle_file_loaded();
         break;
       case MPV_EVENT_TICK: {
+        idle::coordinator().count(idle::Wakeup::Tick);
         // Priority: fetched lyrics > mpv subtitles
         if (has_lyrics && !current_lyrics.empty()) {
           // Use fetched lyrics synced with playback position
@@ -662,7 +884,7 @@ private:
             std::lock_guard<std::mutex> lock(player_mutex);
             lyric_text = lyrics_fetcher->get_current_lyric(current_lyrics, pos);
           }
-          if (!lyric_text.empty() && lyric_text != current_subtitle) {
+          if (!lyric_text.empty() && lyric_text != state.load()->subtitle) {
             update_subtitle(lyric_text.c_str());
           }
         } else {
@@ -685,19 +907,67 @@ private:
   void handle_property_change(mpv_event_property *prop) {
     if (strcmp(prop->name, "time-pos") == 0 &&
                prop->format == MPV_FORMAT_DOUBLE) {
-      current_position = *static_cast<double *>(prop->data);
+      double position = *static_cast<double *>(prop->data);
+      state.set_position(position);
 
       if (on_time_update) {
-        on_time_update(current_position, duration);
+        on_time_update(position, state.load()->duration);
       }
     } else if (strcmp(prop->name, "duration") == 0 &&
                prop->format == MPV_FORMAT_DOUBLE) {
-      duration = *static_cast<double *>(prop->data);
+      double duration = *static_cast<double *>(prop->data);
+      state.update([duration](PlayerState &s) { s.duration = duration; });
+    } else if (strcmp(prop->name, "volume") == 0 &&
+               prop->format == MPV_FORMAT_DOUBLE) {
+      int volume =
+          static_cast<int>(std::lround(*static_cast<double *>(prop->data)));
+      state.update([volume](PlayerState &s) { s.volume = volume; });
+    } else if (strcmp(prop->name, "pause") == 0 &&
+               prop->format == MPV_FORMAT_FLAG) {
+      bool paused = *static_cast<int *>(prop->data) != 0;
+      idle::coordinator().set(idle::Paused, paused);
+      if (state.load()->paused != paused) {
+        state.update([paused](PlayerState &s) { s.paused = paused; });
+        if (on_state_change) {
+          on_state_change();
+        }
+      }
+    } else if (strcmp(prop->name, "idle-active") == 0 &&
+               prop->format == MPV_FORMAT_FLAG) {
+      // Nothing loaded: before the first track, after stop, end of queue
+      idle::coordinator().set(idle::Stopped,
+                              *static_cast<int *>(prop->data) != 0);
+    } else if (adaptive_buffer) {
+      handle_buffer_property(prop);
+    }
+  }
+
+  void handle_buffer_property(mpv_event_property *prop) {
+    if (strcmp(prop->name, "cache-speed") == 0 &&
+        prop->format == MPV_FORMAT_DOUBLE) {
+      adaptive_buffer->on_throughput(*static_cast<double *>(prop->data));
+    } else if (strcmp(prop->name, "audio-bitrate") == 0 &&
+               prop->format == MPV_FORMAT_DOUBLE) {
+      adaptive_buffer->on_bitrate(*static_cast<double *>(prop->data));
+    } else if (strcmp(prop->name, "paused-for-cache") == 0 &&
+               prop->format == MPV_FORMAT_FLAG &&
+               *static_cast<int *>(prop->data)) {
+      adaptive_buffer->on_stall();
+    } else {
+      return;
+    }
+
+    // These are runtime options, so the new sizes apply to the open stream
+    if (auto profile = adaptive_buffer->update()) {
+      for (const auto &[option, value] : profile->mpv_options()) {
+        mpv_set_property_string(mpv.get(), option.c_str(), value.c_str());
+      }
     }
   }
 
   void handle_playback_restart() {
-    is_playing = true;
+    commands.seek_completed();
+    latency::tracker().mark(latency::Stage::PlaybackRestart);
     if (on_state_change) {
       on_state_change();
     }
@@ -713,21 +983,26 @@ private:
   }
 
   void handle_file_loaded() {
-    is_loaded = true;
-    is_playing = true;
-    is_paused = false;
+    latency::tracker().mark(latency::Stage::FileLoaded);
+    if (adaptive_buffer) {
+      adaptive_buffer->on_track_change();
+    }
+    state.update([](PlayerState &s) {
+      s.loaded = true;
+      s.paused = false;
+      s.subtitle.clear();
+    });
 
     // Clear previous lyrics and subtitle, then fetch new ones
     {
       std::lock_guard<std::mutex> lock(player_mutex);
       current_lyrics.clear();
       has_lyrics = false;
-      current_subtitle = "";
 
       // Notify UI to clear subtitle display
       if (on_subtitle_change) {
         try {
-          on_subtitle_change(current_subtitle);
+          on_subtitle_change("");
         } catch (const std::exception &e) {
           log_error("Subtitle callback failed: " + std::string(e.what()));
         }
@@ -741,8 +1016,8 @@ private:
   }
 
 public:
-  bool is_playing_state() const { return is_loaded && !is_paused; }
-  bool is_paused_state() const { return is_loaded && is_paused; }
-  double get_position() const { return current_position; }
-  double get_duration() const { return duration; }
+  bool is_playing_state() const { return state.load()->is_playing(); }
+  bool is_paused_state() const { return state.load()->is_paused(); }
+  double get_position() const { return state.position(); }
+  double get_duration() const { return state.load()->duration; }
 };
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../common/Track.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Immutable view of everything readers ask the player about. A new
+// snapshot is built on every change and swapped in atomically, so UI,
+// MPRIS, Discord and status queries never wait on the player mutex. The
+// playback position is not in it; it changes several times a second and
+// lives in PlayerStatePublisher::position().
+struct PlayerState {
+  bool loaded = false;
+  bool paused = false;
+  double duration = 0.0;
+  int volume = 100;
+  int playlist_index = -1;
+  std::string url;
+  std::string subtitle;
+  // Shared so the frequent position updates don't copy track strings
+  std::shared_ptr<const Track> track;
+  uint64_t version = 0;
+
+  bool is_playing() const { return loaded && !paused; }
+  bool is_paused() const { return loaded && paused; }
+};
+
+class PlayerStatePublisher {
+public:
+  PlayerStatePublisher() : current(std::make_shared<const PlayerState>()) {}
+
+  // The shared_ptr atomics aren't lock-free (libstdc++ guards them with a
+  // small pool of mutexes), so a load can wait, briefly, on a concurrent
+  // store; never on the player mutex or on a writer building a snapshot.
+  std::shared_ptr<const PlayerState> load() const {
+    return std::atomic_load_explicit(&current, std::memory_order_acquire);
+  }
+
+  // Seconds into the track, from mpv's time-pos
+  double position() const { return current_position.load(std::memory_order_relaxed); }
+
+  // Position updates come for every time-pos event; they store one double
+  // instead of copying the snapshot, strings and all
+  void set_position(double seconds) {
+    current_position.store(seconds, std::memory_order_relaxed);
+  }
+
+  // Copy-on-write update; writers are serialized
+  template <typename Fn> std::shared_ptr<const PlayerState> update(Fn &&fn) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    auto next = std::make_shared<PlayerState>(*load());
+    fn(*next);
+    next->version++;
+    std::shared_ptr<const PlayerState> published = std::move(next);
+    std::atomic_store_explicit(&current, published, std::memory_order_release);
+    return published;
+  }
+
+private:
+  std::shared_ptr<const PlayerState> current;
+  std::atomic<double> current_position{0.0};
+  std::mutex write_mutex;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "../common/Track.h"
+#include "../common/executor.hpp"
+#include "../common/notification.hpp"
+#include "play_queue.hpp"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Endless radio: when the queue gets within a few tracks of its end, fetch
+// recommendations seeded from what was played last and append them, so a
+// long session never wraps around and repeats.
+class RadioExtender {
+public:
+  // Returns recommendations for a seed track (Saavn reco, SoundCloud related)
+  using Recommender = std::function<std::vector<Track>(const Track &)>;
+
+  RadioExtender(std::shared_ptr<PlayQueue> play_queue, Recommender fetcher,
+                size_t low_water = 3, size_t seed_count = 3)
+      : queue(std::move(play_queue)), recommend(std::move(fetcher)),
+        low_water(low_water), seed_count(seed_count) {
+    listener = queue->add_listener([this] { maybe_extend(); });
+  }
+
+  ~RadioExtender() { queue->remove_listener(listener); }
+
+  RadioExtender(const RadioExtender &) = delete;
+  RadioExtender &operator=(const RadioExtender &) = delete;
+
+  void set_enabled(bool on) {
+    enabled = on;
+    if (on) {
+      maybe_extend();
+    }
+  }
+
+  bool is_enabled() const { return enabled; }
+
+  bool toggle() {
+    set_enabled(!enabled);
+    return enabled;
+  }
+
+private:
+  std::shared_ptr<PlayQueue> queue;
+  Recommender recommend;
+  size_t low_water;
+  size_t seed_count;
+  int listener = -1;
+  std::atomic_bool enabled{true};
+  std::atomic_bool extending{false};
+
+  void maybe_extend() {
+    if (!enabled || queue->empty() || queue->remaining() >= low_water) {
+      return;
+    }
+    if (extending.exchange(true)) {
+      return; // one extension at a time
+    }
+
+    bool queued = tasks::shared().submit(
+        tasks::Lane::Prefetch, [this](const tasks::CancelToken &token) {
+          try {
+            extend(token);
+          } catch (const std::exception &e) {
+            notifications::send("Radio: " + std::string(e.what()));
+          }
+          extending = false;
+        });
+    if (!queued) {
+      extending = false;
+    }
+  }
+
+  void extend(const tasks::CancelToken &token) {
+    // Everything already queued or recently played is off the table, by
+    // the same Track::key() that history and favourites go by
+    std::unordered_set<std::string> seen;
+    for (const auto &track : queue->snapshot()) {
+      seen.insert(track->key());
+    }
+    auto played = queue->history();
+    for (const auto &track : played) {
+      seen.insert(track->key());
+    }
+
+    // Seed from the most recent distinct plays, newest first
+    std::vector<TrackHandle> seeds;
+    std::unordered_set<std::string> seed_keys;
+    for (auto it = played.rbegin();
+         it != played.rend() && seeds.size() < seed_count; ++it) {
+      if (seed_keys.insert((*it)->key()).second) {
+        seeds.push_back(*it);
+      }
+    }
+
+    std::vector<Track> fresh;
+    for (const auto &seed : seeds) {
+      if (token.cancelled()) {
+        return;
+      }
+      for (auto &track : recommend(*seed)) {
+        if (!track.url.empty() && seen.insert(track.key()).second) {
+          fresh.push_back(std::move(track));
+        }
+      }
+      if (fresh.size() >= low_water * 3) {
+        break; // plenty for now, the next low-water mark fetches more
+      }
+    }
+
+    if (!fresh.empty() && !token.cancelled()) {
+      queue->append(fresh);
+    }
+  }
+};
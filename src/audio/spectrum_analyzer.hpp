@@ -0,0 +1,132 @@
+#pragma once
+
+#include "bar_kernels.hpp"
+#include "fft.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Self-contained spectrum analyser, the default visualizer backend. Same
+// contract as the cavacore AudioVisualizer: interleaved float samples in,
+// bars * CHANNELS values of roughly 0..1 out (left channel's bars first),
+// valid until the next call. Hann window, real FFT, log-spaced bands and
+// a cava-style auto-sensitivity so quiet and loud tracks fill the pane.
+class SpectrumAnalyzer {
+public:
+  static constexpr int SAMPLE_RATE = 44100;
+  static constexpr int CHANNELS = 2;
+  static constexpr size_t FFT_SIZE = 2048; // per channel
+  static constexpr double LOW_CUTOFF = 50;
+  static constexpr double HIGH_CUTOFF = 10000;
+
+  explicit SpectrumAnalyzer(int initial_bars = bars::kMin)
+      : fft(FFT_SIZE), window(FFT_SIZE), channel(FFT_SIZE),
+        spectrum(fft.bins()) {
+    for (size_t i = 0; i < FFT_SIZE; ++i) {
+      window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * i / (FFT_SIZE - 1));
+    }
+    // Sized for the largest count so switching never reallocates
+    band_start.reserve(bars::kMax + 1);
+    band_weight.reserve(bars::kMax);
+    output.reserve(bars::kMax * CHANNELS);
+    set_num_bars(initial_bars);
+  }
+
+  void set_num_bars(int count) {
+    count = bars::snap(count);
+    if (count == bar_count) {
+      return;
+    }
+    bar_count = count;
+    band_start.assign(count + 1, 0);
+    band_weight.assign(count, 0.0);
+    output.assign(count * CHANNELS, 0.0);
+
+    // Log-spaced edges, at least one bin per band
+    const double bin_hz = static_cast<double>(SAMPLE_RATE) / FFT_SIZE;
+    const double ratio = HIGH_CUTOFF / LOW_CUTOFF;
+    for (int b = 0; b <= count; ++b) {
+      double edge = LOW_CUTOFF * std::pow(ratio, static_cast<double>(b) / count);
+      size_t bin = static_cast<size_t>(std::lround(edge / bin_hz));
+      if (b > 0) {
+        bin = std::max(bin, band_start[b - 1] + 1);
+      }
+      band_start[b] = std::min(bin, fft.bins() - 1);
+    }
+
+    // Music falls off roughly like pink noise; tilt the bands back up.
+    // Full-scale sine through a Hann window peaks at FFT_SIZE / 4.
+    for (int b = 0; b < count; ++b) {
+      double center = std::sqrt(static_cast<double>(band_start[b]) *
+                                band_start[b + 1]) * bin_hz;
+      band_weight[b] = std::sqrt(center / LOW_CUTOFF) * 4.0 / FFT_SIZE;
+    }
+  }
+
+  const std::vector<double> &process(const float *samples, size_t count) {
+    size_t frames = std::min(count / CHANNELS, FFT_SIZE);
+    if (frames == 0) {
+      std::fill(output.begin(), output.end(), 0.0);
+      return output;
+    }
+
+    bool silent = true;
+    bool overshoot = false;
+    for (int c = 0; c < CHANNELS; ++c) {
+      // Deinterleave and window; short reads are zero-padded
+      for (size_t i = 0; i < frames; ++i) {
+        channel[i] = samples[i * CHANNELS + c] * window[i];
+      }
+      std::fill(channel.begin() + frames, channel.end(), 0.0);
+
+      fft.forward(channel.data(), spectrum.data());
+
+      double *out = output.data() + c * bar_count;
+      aggregate(out, silent, overshoot);
+    }
+
+    // Back off quickly on clipping, creep up slowly otherwise
+    if (overshoot) {
+      sensitivity *= 0.98;
+    } else if (!silent) {
+      sensitivity = std::min(sensitivity * 1.001, kMaxSensitivity);
+    }
+    for (double &value : output) {
+      value = std::min(value, 1.0);
+    }
+    return output;
+  }
+
+  int get_num_bars() const { return bar_count; }
+
+private:
+  static constexpr double kSilence = 1e-5;
+  static constexpr double kMaxSensitivity = 1e4;
+
+  RealFft fft;
+  std::vector<double> window;
+  std::vector<double> channel;
+  std::vector<RealFft::Complex> spectrum;
+  std::vector<size_t> band_start; // first bin of each band, plus the end
+  std::vector<double> band_weight;
+  std::vector<double> output;
+  int bar_count = 0;
+  double sensitivity = 1.0;
+
+  // Band averages for one channel
+  void aggregate(double *out, bool &silent, bool &overshoot) {
+    for (int b = 0; b < bar_count; ++b) {
+      double sum = 0;
+      for (size_t k = band_start[b]; k < band_start[b + 1]; ++k) {
+        sum += std::sqrt(spectrum[k].re * spectrum[k].re +
+                         spectrum[k].im * spectrum[k].im);
+      }
+      double level =
+          sum / (band_start[b + 1] - band_start[b]) * band_weight[b];
+      silent = silent && level < kSilence;
+      out[b] = level * sensitivity;
+      overshoot = overshoot || out[b] > 1.0;
+    }
+  }
+};
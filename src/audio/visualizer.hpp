@@ -1,16 +1,19 @@
 #pragma once
 
 #include "../cava/cavacore.h"
+#include "../common/simd.hpp"
+#include <algorithm>
+#include <cstdlib>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
 class AudioVisualizer {
 private:
-    struct cava_plan* plan;
+    struct cava_plan* plan = nullptr;
     std::vector<double> input_buffer;
     std::vector<double> output_buffer;
-    static constexpr int BARS = 16;  // Number of frequency bands (matches NUM_BARS in main)
+    int bar_count = 16;  // Number of frequency bands per channel
     static constexpr int SAMPLE_RATE = 44100;
     static constexpr int CHANNELS = 2;
     static constexpr double NOISE_REDUCTION = 0.77;
@@ -19,15 +22,7 @@ private:
 
 public:
     AudioVisualizer() {
-        // Initialize cava
-        plan = cava_init(BARS, SAMPLE_RATE, CHANNELS, 1, 
-                        NOISE_REDUCTION, LOW_CUTOFF, HIGH_CUTOFF);
-        if (plan->status < 0) {
-            throw std::runtime_error(plan->error_message);
-        }
-
-        input_buffer.resize(plan->input_buffer_size);
-        output_buffer.resize(BARS * CHANNELS);
+        init_plan(bar_count);
     }
 
     ~AudioVisualizer() {
@@ -37,23 +32,59 @@ public:
         }
     }
 
-    // Process audio data and return visualization values
-    std::vector<double> process(const std::vector<double>& audio_data) {
-        if (audio_data.empty()) {
-            return std::vector<double>(BARS * CHANNELS, 0.0);
+    // cava fixes the band count per plan, so a new count means a new plan.
+    // If cava rejects it this throws and the current plan stays in use.
+    void set_num_bars(int count) {
+        if (count == bar_count) {
+            return;
         }
+        init_plan(count);
+    }
 
-        // Copy input data
-        size_t samples_to_process = std::min(audio_data.size(), input_buffer.size());
-        std::copy(audio_data.begin(), audio_data.begin() + samples_to_process, 
-                 input_buffer.begin());
+    // Process interleaved samples and return visualization values. Works
+    // on preallocated buffers only; the result stays valid until the next call.
+    const std::vector<double>& process(const float* samples, size_t count) {
+        if (count == 0) {
+            std::fill(output_buffer.begin(), output_buffer.end(), 0.0);
+            return output_buffer;
+        }
+
+        // Widen straight into cava's input buffer
+        size_t samples_to_process = std::min(count, input_buffer.size());
+        simd::convert(samples, input_buffer.data(), samples_to_process);
 
         // Process through cava
-        cava_execute(input_buffer.data(), samples_to_process, 
+        cava_execute(input_buffer.data(), samples_to_process,
                     output_buffer.data(), plan);
 
         return output_buffer;
     }
 
-    int get_num_bars() const { return BARS; }
+    int get_num_bars() const { return bar_count; }
+
+private:
+    // Builds the new plan first and swaps it in only once it is valid
+    void init_plan(int count) {
+        struct cava_plan* next = cava_init(count, SAMPLE_RATE, CHANNELS, 1,
+                                           NOISE_REDUCTION, LOW_CUTOFF, HIGH_CUTOFF);
+        if (!next) {
+            throw std::runtime_error("cava_init failed");
+        }
+        if (next->status < 0) {
+            std::runtime_error error(next->error_message);
+            // cava_init bails out before allocating any buffers, so the
+            // struct itself is all there is to free
+            std::free(next);
+            throw error;
+        }
+
+        if (plan) {
+            cava_destroy(plan);
+        }
+        plan = next;
+        bar_count = count;
+
+        input_buffer.resize(plan->input_buffer_size);
+        output_buffer.assign(bar_count * CHANNELS, 0.0);
+    }
 };
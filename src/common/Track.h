@@ -12,4 +12,29 @@ struct Track {
     std::string to_string() const {
         return name + " - " + artist;
     }
+
+    // Stable identity: the service's own id where there is one, else the
+    // URL. Two songs with the same title still get different keys.
+    std::string key() const {
+        if (!id.empty() && has_unique_id()) {
+            return source + ':' + id;
+        }
+        if (!url.empty()) {
+            return "url:" + url;
+        }
+        return "track:" + artist + '\n' + name; // nothing better to go on
+    }
+
+private:
+    // Last.fm and scraped SoundCloud results used to carry the title or
+    // slug as their id, and saved lists still do
+    bool has_unique_id() const {
+        if (source == "lastfm") {
+            return false;
+        }
+        if (source == "soundcloud") {
+            return id.find_first_not_of("0123456789") == std::string::npos;
+        }
+        return true;
+    }
 };
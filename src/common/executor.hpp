@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tasks {
+
+// Priority lanes. Each lane has its own workers and queue so a slow
+// download can never hold up a track switch.
+enum class Lane {
+  UiCritical, // work the user is waiting on: next tracks, station fetch
+  Prefetch,   // nice-to-have lookups: lyrics, trending list
+  Background, // long running jobs: downloads
+};
+
+// Shared cancellation flag. Tasks poll it between steps and drop their
+// results once it is set.
+class CancelToken {
+public:
+  CancelToken() : flag(std::make_shared<std::atomic_bool>(false)) {}
+
+  void cancel() const { flag->store(true); }
+  bool cancelled() const { return flag->load(); }
+
+  bool operator==(const CancelToken &other) const {
+    return flag == other.flag;
+  }
+
+private:
+  std::shared_ptr<std::atomic_bool> flag;
+};
+
+using Task = std::function<void(const CancelToken &)>;
+
+class Executor {
+private:
+  struct Job {
+    Task task;
+    CancelToken token;
+  };
+
+  struct LaneState {
+    std::string name;
+    size_t capacity = 0;
+    std::deque<Job> queue;
+    std::vector<std::thread> workers;
+    std::condition_variable cv;
+  };
+
+  std::array<LaneState, 3> lanes;
+  std::mutex mutex;
+  bool stopping = false;
+
+  // Latest-wins slots: submitting under the same key cancels the older job
+  std::map<std::string, CancelToken> latest;
+  // Every job that has not finished yet, cancelled in bulk on shutdown
+  std::vector<CancelToken> inflight;
+
+  LaneState &lane(Lane l) { return lanes[static_cast<size_t>(l)]; }
+
+  void worker_loop(LaneState &state) {
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        state.cv.wait(lock, [&] { return stopping || !state.queue.empty(); });
+        if (state.queue.empty()) {
+          return; // stopping and drained
+        }
+        job = std::move(state.queue.front());
+        state.queue.pop_front();
+      }
+
+      if (!job.token.cancelled()) {
+        try {
+          job.task(job.token);
+        } catch (...) {
+          // Tasks report their own errors; never let one kill a worker
+        }
+      }
+      forget(job.token);
+    }
+  }
+
+  void forget(const CancelToken &token) {
+    std::lock_guard<std::mutex> lock(mutex);
+    forget_locked(token);
+  }
+
+  void forget_locked(const CancelToken &token) {
+    auto it = std::find(inflight.begin(), inflight.end(), token);
+    if (it != inflight.end()) {
+      inflight.erase(it);
+    }
+  }
+
+public:
+  Executor() : Executor(1, 2, 1) {}
+
+  Executor(size_t ui_workers, size_t prefetch_workers,
+           size_t background_workers) {
+    const size_t workers[] = {ui_workers, prefetch_workers, background_workers};
+    const char *names[] = {"ui", "prefetch", "background"};
+    const size_t capacities[] = {8, 16, 4};
+
+    for (size_t i = 0; i < lanes.size(); ++i) {
+      lanes[i].name = names[i];
+      lanes[i].capacity = capacities[i];
+      for (size_t w = 0; w < std::max<size_t>(workers[i], 1); ++w) {
+        LaneState &state = lanes[i];
+        state.workers.emplace_back([this, &state] { worker_loop(state); });
+      }
+    }
+  }
+
+  ~Executor() { shutdown(); }
+
+  Executor(const Executor &) = delete;
+  Executor &operator=(const Executor &) = delete;
+
+  // Queue a task; returns false when the lane is full or shutting down
+  bool submit(Lane l, Task task, CancelToken token = CancelToken()) {
+    LaneState &state = lane(l);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopping || state.queue.size() >= state.capacity) {
+        return false;
+      }
+      inflight.push_back(token);
+      state.queue.push_back(Job{std::move(task), token});
+    }
+    state.cv.notify_one();
+    return true;
+  }
+
+  // Queue a task that supersedes any earlier one with the same key. The
+  // older job is cancelled: skipped if still queued, told to stop if running.
+  CancelToken submit_latest(Lane l, const std::string &key, Task task) {
+    CancelToken token;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = latest.find(key);
+      if (it != latest.end()) {
+        it->second.cancel();
+      }
+      latest[key] = token;
+
+      // Drop superseded jobs that never started so they don't hold slots
+      LaneState &state = lane(l);
+      for (auto q = state.queue.begin(); q != state.queue.end();) {
+        if (q->token.cancelled()) {
+          forget_locked(q->token);
+          q = state.queue.erase(q);
+        } else {
+          ++q;
+        }
+      }
+    }
+    if (!submit(l, std::move(task), token)) {
+      token.cancel();
+    }
+    return token;
+  }
+
+  // Cancel everything still pending or running and join the workers
+  void shutdown() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stopping) {
+        return;
+      }
+      stopping = true;
+      for (auto &state : lanes) {
+        for (auto &job : state.queue) {
+          job.token.cancel();
+        }
+      }
+      for (auto &token : inflight) {
+        token.cancel();
+      }
+    }
+
+    for (auto &state : lanes) {
+      state.cv.notify_all();
+    }
+    for (auto &state : lanes) {
+      for (auto &worker : state.workers) {
+        if (worker.joinable()) {
+          worker.join();
+        }
+      }
+    }
+  }
+};
+
+// Process-wide executor shared by the player, UI and integrations
+inline Executor &shared() {
+  static Executor executor;
+  return executor;
+}
+
+} // namespace tasks
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <string>
+#include <vector>
+#include "executor.hpp"
+#include "paths.hpp"
+
+namespace idle {
+
+// Why the app has nothing worth doing in the background. Any one of them
+// set makes the whole process idle.
+enum Reason : unsigned {
+  Paused = 1u << 0,
+  Stopped = 1u << 1,
+  Unfocused = 1u << 2, // terminal lost focus; most also report hidden that way
+};
+
+// Background wakeups worth counting while idle; ideally all stay at zero
+enum class Wakeup {
+  Redraw,     // PostEvent from a timer or the player, not from input
+  Tick,       // MPV_EVENT_TICK lyric/subtitle polling
+  AudioFrame, // frame handled by the visualizer DSP thread
+  ClockTick,  // render clock woke up to check for changes
+  Count
+};
+
+inline const char *wakeup_name(Wakeup wakeup) {
+  switch (wakeup) {
+  case Wakeup::Redraw: return "redraw";
+  case Wakeup::Tick: return "tick";
+  case Wakeup::AudioFrame: return "audio_frame";
+  case Wakeup::ClockTick: return "clock_tick";
+  default: return "total";
+  }
+}
+
+class Coordinator;
+
+// Keeps a listener registered for as long as it lives
+class Subscription {
+public:
+  Subscription() = default;
+  Subscription(Coordinator *source, int listener_id)
+      : owner(source), id(listener_id) {}
+  Subscription(Subscription &&other) noexcept
+      : owner(other.owner), id(other.id) {
+    other.owner = nullptr;
+  }
+  Subscription &operator=(Subscription &&other) noexcept;
+  ~Subscription() { reset(); }
+
+  void reset();
+
+private:
+  Coordinator *owner = nullptr;
+  int id = 0;
+};
+
+// Single place that decides idle vs. active. Subsystems subscribe and
+// suspend or resume themselves on transitions; producers count the
+// wakeups they still cause so leaks show up in `--cmd idle`.
+class Coordinator {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Listener = std::function<void(bool idle)>;
+
+  // Called once right away with the current state, then on every
+  // transition. Listeners run on the transitioning thread with the
+  // coordinator locked, in registration order; they must not call back
+  // into set/assign, and must not block: that thread may be the UI's.
+  [[nodiscard]] Subscription subscribe(Listener listener) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listener(idle_flag.load(std::memory_order_relaxed));
+    listeners.emplace_back(++last_id, std::move(listener));
+    return Subscription(this, last_id);
+  }
+
+  void unsubscribe(int id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+      if (it->first == id) {
+        listeners.erase(it);
+        break;
+      }
+    }
+  }
+
+  // Only the interactive instance writes the dump `--cmd idle` reads
+  void enable_dump() {
+    std::lock_guard<std::mutex> lock(mutex);
+    dump_enabled = true;
+  }
+
+  static std::string dump_path() {
+    return paths::get_cache_dir() + "/idle.json";
+  }
+
+  void set(unsigned reasons, bool on) {
+    bool changed;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      changed = apply_locked(on ? active_reasons | reasons
+                                : active_reasons & ~reasons);
+    }
+    if (changed) {
+      schedule_dump();
+    }
+  }
+
+  // Overwrites the reasons in `mask` with the matching bits of `values`
+  void assign(unsigned mask, unsigned values) {
+    bool changed;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      changed = apply_locked((active_reasons & ~mask) | (values & mask));
+    }
+    if (changed) {
+      schedule_dump();
+    }
+  }
+
+  bool is_idle() const { return idle_flag.load(std::memory_order_relaxed); }
+
+  // Cheap enough for hot paths: a relaxed load when active
+  void count(Wakeup wakeup) {
+    if (is_idle()) {
+      wakeups[static_cast<size_t>(wakeup)].fetch_add(
+          1, std::memory_order_relaxed);
+    }
+  }
+
+  std::string to_json() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return to_json_locked();
+  }
+
+private:
+  mutable std::mutex mutex;
+  std::vector<std::pair<int, Listener>> listeners;
+  int last_id = 0;
+  bool dump_enabled = false;
+  unsigned active_reasons = 0;
+  std::atomic<bool> idle_flag{false};
+  Clock::time_point idle_since;
+  std::chrono::duration<double> idle_total{0};
+  std::array<std::atomic<uint64_t>, static_cast<size_t>(Wakeup::Count)>
+      wakeups{};
+
+  static double seconds_since(Clock::time_point since) {
+    return std::chrono::duration<double>(Clock::now() - since).count();
+  }
+
+  std::string to_json_locked() const {
+    rapidjson::Document doc;
+    doc.SetObject();
+    auto &allocator = doc.GetAllocator();
+
+    doc.AddMember("idle", idle_flag.load(std::memory_order_relaxed),
+                  allocator);
+    rapidjson::Value reasons(rapidjson::kArrayType);
+    if (active_reasons & Paused) reasons.PushBack("paused", allocator);
+    if (active_reasons & Stopped) reasons.PushBack("stopped", allocator);
+    if (active_reasons & Unfocused) reasons.PushBack("unfocused", allocator);
+    doc.AddMember("reasons", reasons, allocator);
+
+    double seconds = idle_total.count();
+    if (idle_flag.load(std::memory_order_relaxed)) {
+      seconds += seconds_since(idle_since);
+    }
+    doc.AddMember("idle_seconds", seconds, allocator);
+
+    rapidjson::Value counts(rapidjson::kObjectType);
+    uint64_t total = 0;
+    for (size_t i = 0; i < wakeups.size(); ++i) {
+      uint64_t n = wakeups[i].load(std::memory_order_relaxed);
+      total += n;
+      counts.AddMember(rapidjson::StringRef(wakeup_name(static_cast<Wakeup>(i))),
+                       n, allocator);
+    }
+    counts.AddMember("total", total, allocator);
+    doc.AddMember("wakeups_while_idle", counts, allocator);
+    doc.AddMember("wakeups_per_idle_minute",
+                  seconds > 0 ? total * 60.0 / seconds : 0.0, allocator);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+    return buffer.GetString();
+  }
+
+  // Whether idle flipped
+  bool apply_locked(unsigned reasons) {
+    active_reasons = reasons;
+    bool idle = reasons != 0;
+    if (idle == idle_flag.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (idle) {
+      idle_since = Clock::now();
+    } else {
+      idle_total += Clock::now() - idle_since;
+    }
+    idle_flag.store(idle, std::memory_order_relaxed);
+    for (const auto &entry : listeners) {
+      entry.second(idle);
+    }
+    return true;
+  }
+
+  // The dump is written off the transitioning thread, from the state at
+  // the time the job runs; a newer transition replaces a pending write.
+  void schedule_dump() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!dump_enabled) {
+        return;
+      }
+    }
+    tasks::shared().submit_latest(tasks::Lane::Prefetch, "idle-dump",
+                                  [this](const tasks::CancelToken &) {
+                                    std::string json = to_json();
+                                    paths::ensure_directory_exists(
+                                        paths::get_cache_dir());
+                                    std::ofstream file(dump_path(), std::ios::trunc);
+                                    file << json << std::endl;
+                                  });
+  }
+};
+
+inline Coordinator &coordinator() {
+  static Coordinator instance;
+  return instance;
+}
+
+inline Subscription &Subscription::operator=(Subscription &&other) noexcept {
+  if (this != &other) {
+    reset();
+    owner = other.owner;
+    id = other.id;
+    other.owner = nullptr;
+  }
+  return *this;
+}
+
+inline void Subscription::reset() {
+  if (owner) {
+    owner->unsubscribe(id);
+    owner = nullptr;
+  }
+}
+
+} // namespace idle
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <string>
+#include "paths.hpp"
+
+namespace latency {
+
+// Stages between pressing Enter and hearing audio, in the order they happen
+enum class Stage {
+  RecoFetch,       // next-track recommendations
+  CreatePlaylist,  // building the mpv playlist
+  Loadfile,        // loadfile issued until mpv starts the file
+  YtdlHook,        // start of file until ytdl_hook has resolved the stream
+  FileLoaded,      // demuxer open, MPV_EVENT_FILE_LOADED
+  PlaybackRestart, // first audio out, MPV_EVENT_PLAYBACK_RESTART
+  Count
+};
+
+inline const char *stage_name(Stage stage) {
+  switch (stage) {
+  case Stage::RecoFetch: return "reco_fetch";
+  case Stage::CreatePlaylist: return "create_playlist";
+  case Stage::Loadfile: return "loadfile";
+  case Stage::YtdlHook: return "ytdl_hook";
+  case Stage::FileLoaded: return "file_loaded";
+  case Stage::PlaybackRestart: return "playback_restart";
+  default: return "total";
+  }
+}
+
+// Power-of-two millisecond buckets: [0,1) [1,2) [2,4) ... [32768,inf)
+class Histogram {
+public:
+  static constexpr size_t kBuckets = 17;
+
+  void add(double ms) {
+    size_t bucket = 0;
+    for (double edge = 1; bucket + 1 < kBuckets && ms >= edge; edge *= 2) {
+      bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    sum_ms += ms;
+  }
+
+  // Upper edge of the bucket holding the given quantile
+  double quantile(double q) const {
+    if (count == 0) {
+      return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(q * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += buckets[i];
+      if (seen >= target) {
+        return static_cast<double>(uint64_t{1} << i);
+      }
+    }
+    return static_cast<double>(uint64_t{1} << (kBuckets - 1));
+  }
+
+  std::array<uint64_t, kBuckets> buckets{};
+  uint64_t count = 0;
+  double sum_ms = 0;
+};
+
+// Collects one span per stage for each load, from the first stage mark
+// (Enter, or mpv starting a file on its own) to first audio.
+class Tracker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Start a fresh measurement; anything in flight is discarded
+  void begin() {
+    std::lock_guard<std::mutex> lock(mutex);
+    start_session(Clock::now());
+  }
+
+  // Records the time since the previous mark as this stage's span.
+  // A mark with no session open starts one, so auto-advance and IPC
+  // loads get measured from the point the player sees them.
+  void mark(Stage stage) {
+    auto now = Clock::now();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active) {
+      if (stage == Stage::PlaybackRestart) {
+        return; // a plain seek, not a load
+      }
+      start_session(now);
+    }
+
+    double span = ms_between(last_mark, now);
+    histograms[static_cast<size_t>(stage)].add(span);
+    last_spans[static_cast<size_t>(stage)] = span;
+    last_mark = now;
+
+    if (stage == Stage::PlaybackRestart) {
+      last_total_ms = ms_between(session_start, now);
+      total.add(last_total_ms);
+      active = false;
+      dump_locked();
+    }
+  }
+
+  // Status line text, e.g. "start 1840ms (reco_fetch 1100ms)"
+  std::string summary() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (total.count == 0) {
+      return "";
+    }
+    size_t slowest = 0;
+    for (size_t i = 1; i < last_spans.size(); ++i) {
+      if (last_spans[i] > last_spans[slowest]) {
+        slowest = i;
+      }
+    }
+    return "start " + std::to_string(static_cast<int>(last_total_ms)) +
+           "ms (" + stage_name(static_cast<Stage>(slowest)) + " " +
+           std::to_string(static_cast<int>(last_spans[slowest])) + "ms)";
+  }
+
+  template <typename Allocator>
+  void append_json(rapidjson::Value &out, Allocator &allocator) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    fill_json_locked(out, allocator);
+  }
+
+  std::string to_json() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return to_json_locked();
+  }
+
+  // Where the last breakdown is written for `tuisic --cmd latency`
+  static std::string dump_path() {
+    return paths::get_cache_dir() + "/latency.json";
+  }
+
+private:
+  mutable std::mutex mutex;
+  std::array<Histogram, static_cast<size_t>(Stage::Count)> histograms;
+  std::array<double, static_cast<size_t>(Stage::Count)> last_spans{};
+  Histogram total;
+  double last_total_ms = 0;
+
+  bool active = false;
+  Clock::time_point session_start;
+  Clock::time_point last_mark;
+
+  void start_session(Clock::time_point now) {
+    active = true;
+    session_start = now;
+    last_mark = now;
+    last_spans.fill(0);
+  }
+
+  static double ms_between(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+  }
+
+  template <typename Allocator>
+  static void write_histogram(rapidjson::Value &out, const Histogram &h,
+                              double last, Allocator &allocator) {
+    out.AddMember("count", static_cast<uint64_t>(h.count), allocator);
+    out.AddMember("last_ms", last, allocator);
+    out.AddMember("mean_ms", h.count ? h.sum_ms / h.count : 0.0, allocator);
+    out.AddMember("p50_ms", h.quantile(0.5), allocator);
+    out.AddMember("p95_ms", h.quantile(0.95), allocator);
+    rapidjson::Value buckets(rapidjson::kArrayType);
+    for (uint64_t n : h.buckets) {
+      buckets.PushBack(n, allocator);
+    }
+    out.AddMember("buckets", buckets, allocator);
+  }
+
+  template <typename Allocator>
+  void fill_json_locked(rapidjson::Value &out, Allocator &allocator) const {
+    out.SetObject();
+    for (size_t i = 0; i < histograms.size(); ++i) {
+      rapidjson::Value stage(rapidjson::kObjectType);
+      write_histogram(stage, histograms[i], last_spans[i], allocator);
+      out.AddMember(rapidjson::StringRef(stage_name(static_cast<Stage>(i))),
+                    stage, allocator);
+    }
+    rapidjson::Value overall(rapidjson::kObjectType);
+    write_histogram(overall, total, last_total_ms, allocator);
+    out.AddMember("total", overall, allocator);
+  }
+
+  std::string to_json_locked() const {
+    rapidjson::Document doc;
+    fill_json_locked(doc, doc.GetAllocator());
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+    return buffer.GetString();
+  }
+
+  void dump_locked() const {
+    paths::ensure_directory_exists(paths::get_cache_dir());
+    std::ofstream file(dump_path(), std::ios::trunc);
+    file << to_json_locked() << std::endl;
+  }
+};
+
+inline Tracker &tracker() {
+  static Tracker instance;
+  return instance;
+}
+
+} // namespace latency
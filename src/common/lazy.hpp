@@ -0,0 +1,39 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+// A global built on first use instead of before main(). `--cmd` and
+// `--mcp-server` only pay for the subsystems they actually touch; a
+// command forwarded to a running instance touches none. Access after the
+// first is one atomic check.
+template <typename T> class Lazy {
+public:
+  using Factory = std::function<std::shared_ptr<T>()>;
+
+  Lazy() : make([] { return std::make_shared<T>(); }) {}
+  explicit Lazy(Factory factory) : make(std::move(factory)) {}
+
+  Lazy(const Lazy &) = delete;
+  Lazy &operator=(const Lazy &) = delete;
+
+  const std::shared_ptr<T> &shared() {
+    std::call_once(once, [this] { value = make(); });
+    return value;
+  }
+
+  T &get() { return *shared(); }
+  T *operator->() { return shared().get(); }
+  T &operator*() { return get(); }
+
+  // Drop-in where the eager global used to be passed along
+  operator T &() { return get(); }
+  operator std::shared_ptr<T>() { return shared(); }
+
+private:
+  Factory make;
+  std::once_flag once;
+  std::shared_ptr<T> value;
+};
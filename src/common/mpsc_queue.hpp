@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Multi-producer single-consumer queue (Vyukov's intrusive design).
+// Producers push with one atomic exchange and never wait on each other or
+// on the consumer; the consumer pops without locks. A pop that races a
+// push still in progress reports empty and finds the item next time.
+template <typename T> class MpscQueue {
+public:
+  MpscQueue() : head(&stub), tail(&stub) {}
+
+  ~MpscQueue() {
+    T value;
+    while (pop(value)) {
+    }
+  }
+
+  MpscQueue(const MpscQueue &) = delete;
+  MpscQueue &operator=(const MpscQueue &) = delete;
+
+  // Any thread
+  void push(T value) {
+    Node *node = new Node;
+    node->value = std::move(value);
+    link(node);
+  }
+
+  // Consumer only: oldest item, or false when there is none (yet)
+  bool pop(T &out) {
+    Node *first = tail;
+    Node *next = first->next.load(std::memory_order_acquire);
+    if (first == &stub) {
+      if (!next) {
+        return false;
+      }
+      tail = next;
+      first = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (!next) {
+      if (first != head.load(std::memory_order_acquire)) {
+        return false; // a producer has swapped head but not linked yet
+      }
+      // `first` is the last item; park the stub behind it so it can go
+      link(&stub);
+      next = first->next.load(std::memory_order_acquire);
+      if (!next) {
+        return false;
+      }
+    }
+    tail = next;
+    out = std::move(first->value);
+    delete first;
+    return true;
+  }
+
+private:
+  struct Node {
+    std::atomic<Node *> next{nullptr};
+    T value;
+  };
+
+  Node stub;
+  std::atomic<Node *> head; // last pushed, written by producers
+  Node *tail;               // next to pop, consumer only
+
+  void link(Node *node) {
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+};
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Fixed-rate redraw driver. Producers only publish data; once per tick the
+// clock asks whether anything changed and requests a single redraw if so,
+// so the frame rate no longer follows how often audio buffers arrive.
+class RenderClock {
+public:
+  using Probe = std::function<bool()>; // true when there is something new
+  using Redraw = std::function<void()>;
+
+  static constexpr int kMinFps = 1;
+  static constexpr int kMaxFps = 120;
+
+  RenderClock(int fps, Probe changed, Redraw redraw)
+      : period(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(
+                1.0 / std::clamp(fps, kMinFps, kMaxFps)))),
+        changed(std::move(changed)), redraw(std::move(redraw)),
+        worker([this] { run(); }) {}
+
+  ~RenderClock() { stop(); }
+
+  RenderClock(const RenderClock &) = delete;
+  RenderClock &operator=(const RenderClock &) = delete;
+
+  // A paused clock sleeps until resumed instead of ticking
+  void set_paused(bool value) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      paused = value;
+    }
+    wake.notify_all();
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  Clock::duration period;
+  Probe changed;
+  Redraw redraw;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  bool stopping = false;
+  bool paused = false;
+  std::thread worker; // last, so everything above exists when it starts
+
+  void run() {
+    auto next = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+      if (paused) {
+        wake.wait(lock, [this] { return stopping || !paused; });
+        next = Clock::now();
+        continue;
+      }
+      next += period;
+      if (wake.wait_until(lock, next, [this] { return stopping || paused; })) {
+        continue;
+      }
+      // Fell behind (suspend, heavy load): skip missed ticks, don't burst
+      auto now = Clock::now();
+      if (now - next > period) {
+        next = now;
+      }
+      lock.unlock();
+      if (changed()) {
+        redraw();
+      }
+      lock.lock();
+    }
+  }
+};
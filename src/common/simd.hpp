@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Small portable wrapper over whatever vector unit the build targets (AVX,
+// SSE2, NEON, or plain scalar). Kernels are written once against F64 and
+// finish the tail that doesn't fill a vector with scalar code.
+namespace simd {
+
+#if defined(__AVX__)
+constexpr const char *kBackend = "avx";
+
+struct F64 {
+  static constexpr size_t width = 4;
+  __m256d v;
+
+  static F64 load(const double *p) { return {_mm256_loadu_pd(p)}; }
+  static F64 load_f32(const float *p) {
+    return {_mm256_cvtps_pd(_mm_loadu_ps(p))};
+  }
+  static F64 splat(double x) { return {_mm256_set1_pd(x)}; }
+  void store(double *p) const { _mm256_storeu_pd(p, v); }
+};
+
+inline F64 operator+(F64 a, F64 b) { return {_mm256_add_pd(a.v, b.v)}; }
+inline F64 operator-(F64 a, F64 b) { return {_mm256_sub_pd(a.v, b.v)}; }
+inline F64 operator*(F64 a, F64 b) { return {_mm256_mul_pd(a.v, b.v)}; }
+
+// Lane-wise a > b ? yes : no
+inline F64 select_gt(F64 a, F64 b, F64 yes, F64 no) {
+  return {_mm256_blendv_pd(no.v, yes.v, _mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ))};
+}
+
+#elif defined(__SSE2__)
+constexpr const char *kBackend = "sse2";
+
+struct F64 {
+  static constexpr size_t width = 2;
+  __m128d v;
+
+  static F64 load(const double *p) { return {_mm_loadu_pd(p)}; }
+  static F64 load_f32(const float *p) {
+    // Only the low two floats are read and widened
+    return {_mm_cvtps_pd(
+        _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(p)))};
+  }
+  static F64 splat(double x) { return {_mm_set1_pd(x)}; }
+  void store(double *p) const { _mm_storeu_pd(p, v); }
+};
+
+inline F64 operator+(F64 a, F64 b) { return {_mm_add_pd(a.v, b.v)}; }
+inline F64 operator-(F64 a, F64 b) { return {_mm_sub_pd(a.v, b.v)}; }
+inline F64 operator*(F64 a, F64 b) { return {_mm_mul_pd(a.v, b.v)}; }
+
+inline F64 select_gt(F64 a, F64 b, F64 yes, F64 no) {
+  __m128d mask = _mm_cmpgt_pd(a.v, b.v);
+  return {_mm_or_pd(_mm_and_pd(mask, yes.v), _mm_andnot_pd(mask, no.v))};
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+constexpr const char *kBackend = "neon";
+
+struct F64 {
+  static constexpr size_t width = 2;
+  float64x2_t v;
+
+  static F64 load(const double *p) { return {vld1q_f64(p)}; }
+  static F64 load_f32(const float *p) { return {vcvt_f64_f32(vld1_f32(p))}; }
+  static F64 splat(double x) { return {vdupq_n_f64(x)}; }
+  void store(double *p) const { vst1q_f64(p, v); }
+};
+
+inline F64 operator+(F64 a, F64 b) { return {vaddq_f64(a.v, b.v)}; }
+inline F64 operator-(F64 a, F64 b) { return {vsubq_f64(a.v, b.v)}; }
+inline F64 operator*(F64 a, F64 b) { return {vmulq_f64(a.v, b.v)}; }
+
+inline F64 select_gt(F64 a, F64 b, F64 yes, F64 no) {
+  return {vbslq_f64(vcgtq_f64(a.v, b.v), yes.v, no.v)};
+}
+
+#else
+constexpr const char *kBackend = "scalar";
+
+struct F64 {
+  static constexpr size_t width = 1;
+  double v;
+
+  static F64 load(const double *p) { return {*p}; }
+  static F64 load_f32(const float *p) { return {static_cast<double>(*p)}; }
+  static F64 splat(double x) { return {x}; }
+  void store(double *p) const { *p = v; }
+};
+
+inline F64 operator+(F64 a, F64 b) { return {a.v + b.v}; }
+inline F64 operator-(F64 a, F64 b) { return {a.v - b.v}; }
+inline F64 operator*(F64 a, F64 b) { return {a.v * b.v}; }
+
+inline F64 select_gt(F64 a, F64 b, F64 yes, F64 no) {
+  return a.v > b.v ? yes : no;
+}
+#endif
+
+// out[i] = in[i], widened from float
+inline void convert(const float *in, double *out, size_t n) {
+  size_t i = 0;
+  for (const size_t end = n - n % F64::width; i < end; i += F64::width) {
+    F64::load_f32(in + i).store(out + i);
+  }
+  for (; i < n; ++i) {
+    out[i] = static_cast<double>(in[i]);
+  }
+}
+
+// out[i] = in[i] * window[i]: widening and windowing in one pass
+inline void convert_windowed(const float *in, const double *window,
+                             double *out, size_t n) {
+  size_t i = 0;
+  for (const size_t end = n - n % F64::width; i < end; i += F64::width) {
+    (F64::load_f32(in + i) * F64::load(window + i)).store(out + i);
+  }
+  for (; i < n; ++i) {
+    out[i] = static_cast<double>(in[i]) * window[i];
+  }
+}
+
+// Moves state toward target in place: by `rise` of the gap when the
+// target is higher, by `fall` when it is lower (fast attack, slow decay)
+inline void smooth(double *state, const double *target, size_t n, double rise,
+                   double fall) {
+  const F64 rise_v = F64::splat(rise);
+  const F64 fall_v = F64::splat(fall);
+  size_t i = 0;
+  for (const size_t end = n - n % F64::width; i < end; i += F64::width) {
+    F64 s = F64::load(state + i);
+    F64 t = F64::load(target + i);
+    F64 rate = select_gt(t, s, rise_v, fall_v);
+    (s + (t - s) * rate).store(state + i);
+  }
+  for (; i < n; ++i) {
+    double rate = target[i] > state[i] ? rise : fall;
+    state[i] += (target[i] - state[i]) * rate;
+  }
+}
+
+} // namespace simd
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Single-producer single-consumer ring of preallocated slots. The producer
+// fills a slot in place and commits it; the consumer reads a slot in place
+// and releases it. Neither side locks, allocates or waits on the other: a
+// full ring hands the producer nothing and the frame is counted as dropped.
+template <typename T, size_t Capacity> class SpscRing {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "capacity must be a power of two");
+
+public:
+  // Producer: slot to fill, or nullptr when the consumer has fallen behind
+  T *write_slot() {
+    size_t head = write_index.load(std::memory_order_relaxed);
+    if (head - cached_read >= Capacity) {
+      cached_read = read_index.load(std::memory_order_acquire);
+      if (head - cached_read >= Capacity) {
+        return nullptr;
+      }
+    }
+    return &slots[head & (Capacity - 1)];
+  }
+
+  // Producer: make the slot returned by write_slot() visible
+  void commit() {
+    write_index.store(write_index.load(std::memory_order_relaxed) + 1,
+                      std::memory_order_release);
+  }
+
+  // Producer: a frame had nowhere to go
+  void drop() { dropped.fetch_add(1, std::memory_order_relaxed); }
+
+  // Consumer: oldest committed slot, or nullptr when empty
+  const T *read_slot() {
+    size_t tail = read_index.load(std::memory_order_relaxed);
+    if (tail == cached_write) {
+      cached_write = write_index.load(std::memory_order_acquire);
+      if (tail == cached_write) {
+        return nullptr;
+      }
+    }
+    return &slots[tail & (Capacity - 1)];
+  }
+
+  // Consumer: hand the slot from read_slot() back to the producer
+  void release() {
+    read_index.store(read_index.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_release);
+  }
+
+  bool empty() const {
+    return read_index.load(std::memory_order_acquire) ==
+           write_index.load(std::memory_order_acquire);
+  }
+
+  uint64_t dropped_count() const {
+    return dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  // Each side's index and its cached copy of the other side's index share
+  // a cache line; the two sides never write the same line
+  alignas(64) std::atomic<size_t> write_index{0};
+  size_t cached_read = 0;
+  alignas(64) std::atomic<size_t> read_index{0};
+  size_t cached_write = 0;
+  alignas(64) std::atomic<uint64_t> dropped{0};
+  std::array<T, Capacity> slots{};
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Latest-value handoff between one writer and one reader. The writer
+// always has a private buffer to fill, the reader always has a stable one
+// to draw from, and the third sits in the middle holding the newest
+// publish. Neither side ever waits; intermediate values are skipped.
+template <typename T> class TripleBuffer {
+public:
+  TripleBuffer() = default;
+
+  // All three buffers start as copies of the initial value, so vectors can
+  // be sized once up front and only overwritten afterwards
+  explicit TripleBuffer(const T &initial) { buffers.fill(initial); }
+
+  // Same, for buffers sized after construction; before any publish only
+  void reset(const T &initial) { buffers.fill(initial); }
+
+  // Writer: buffer to fill for the next publish
+  T &write_buffer() { return buffers[back]; }
+
+  // Writer: swap the filled buffer into the middle slot
+  void publish() {
+    uint8_t previous = middle.exchange(static_cast<uint8_t>(back | kFresh),
+                                       std::memory_order_acq_rel);
+    back = previous & kIndexMask;
+  }
+
+  // Reader: pick up the newest publish if there is one. Returns whether
+  // read_buffer() changed.
+  bool update() {
+    if (!(middle.load(std::memory_order_relaxed) & kFresh)) {
+      return false;
+    }
+    uint8_t previous = middle.exchange(front, std::memory_order_acq_rel);
+    front = previous & kIndexMask;
+    return true;
+  }
+
+  // Reader: last picked-up value, stable until the next update()
+  const T &read_buffer() const { return buffers[front]; }
+
+private:
+  static constexpr uint8_t kIndexMask = 0x3;
+  static constexpr uint8_t kFresh = 0x4;
+
+  std::array<T, 3> buffers{};
+  uint8_t back = 0;                // writer-owned
+  std::atomic<uint8_t> middle{1};  // shared, with the fresh bit
+  uint8_t front = 2;               // reader-owned
+};
@@ -4,6 +4,9 @@
 #include <fstream>
 #include <iostream>
 #include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 #include <rapidjson/document.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
@@ -42,6 +45,9 @@ private:
     player.AddMember("volume", 100, allocator);
     player.AddMember("subtitle_enabled", true, allocator);
     player.AddMember("repeat_enabled", false, allocator);
+    // low-latency, balanced, low-memory or adaptive
+    player.AddMember("buffer_profile", "balanced", allocator);
+    player.AddMember("radio", true, allocator);
     
     // MPV-specific settings
     rapidjson::Value mpv_options(rapidjson::kObjectType);
@@ -69,8 +75,21 @@ private:
     ui.AddMember("theme", "dark", allocator);
     ui.AddMember("show_notifications", true, allocator);
     ui.AddMember("notification_timeout", 3000, allocator);
+    ui.AddMember("visualizer_fps", 30, allocator);
+    ui.AddMember("visualizer_source", "mpv", allocator);
+    ui.AddMember("idle_when_unfocused", true, allocator);
+    ui.AddMember("max_fps", 30, allocator);
+    ui.AddMember("show_render_stats", false, allocator);
     config.AddMember("ui", ui, allocator);
 
+    // Storage section
+    rapidjson::Value storage(rapidjson::kObjectType);
+    // always, interval or never
+    storage.AddMember("journal_fsync", "always", allocator);
+    storage.AddMember("journal_compact_every", 256, allocator);
+    storage.AddMember("history_recent_limit", 500, allocator);
+    config.AddMember("storage", storage, allocator);
+
     // Cache section
     rapidjson::Value cache(rapidjson::kObjectType);
     cache.AddMember("enabled", true, allocator);
@@ -201,10 +220,58 @@ public:
 
   int get_volume() const { return get_int_value("player", "volume", 100); }
 
+  // Keep extending the queue with recommendations before it runs out
+  bool get_radio_enabled() const {
+    return get_bool_value("player", "radio", true);
+  }
+
   bool get_notifications_enabled() const {
     return get_bool_value("ui", "show_notifications", true);
   }
 
+  // Redraw rate of the visualizer pane, e.g. 30 or 60
+  int get_visualizer_fps() const {
+    return get_int_value("ui", "visualizer_fps", 30);
+  }
+
+  // "mpv" taps tuisic's own decoded audio; "pulse" records the default
+  // sink's monitor (PulseAudio builds only); "none" turns the bars off
+  std::string get_visualizer_source() const {
+    return get_string_value("ui", "visualizer_source", "mpv");
+  }
+
+  // Treat a terminal that lost focus like a paused player: no visualizer,
+  // no lyric polling, redraws on input only
+  bool get_idle_when_unfocused() const {
+    return get_bool_value("ui", "idle_when_unfocused", true);
+  }
+
+  // Cap on redraws per second, whatever asks for them
+  int get_max_fps() const { return get_int_value("ui", "max_fps", 30); }
+
+  // Frames and redraw requests per second in the status bar
+  bool get_show_render_stats() const {
+    return get_bool_value("ui", "show_render_stats", false);
+  }
+
+  // When history/favourite journal appends reach the disk: "always" syncs
+  // each record, "interval" at most once a second, "never" leaves it to
+  // the OS
+  std::string get_journal_fsync() const {
+    return get_string_value("storage", "journal_fsync", "always");
+  }
+
+  // Journal records after which it is folded into tracks.json
+  int get_journal_compact_every() const {
+    return get_int_value("storage", "journal_compact_every", 256);
+  }
+
+  // Plays kept in memory and in tracks.json; the full history stays in
+  // history.log
+  int get_history_recent_limit() const {
+    return get_int_value("storage", "history_recent_limit", 500);
+  }
+
   // MPV settings getters
   std::string get_mpv_option(const std::string& option, const std::string& default_value = "") const {
     std::lock_guard<std::mutex> lock(config_mutex);
@@ -216,6 +283,25 @@ public:
     return default_value;
   }
 
+  // Every string option under player.mpv_options, in file order
+  std::vector<std::pair<std::string, std::string>> get_mpv_options() const {
+    std::lock_guard<std::mutex> lock(config_mutex);
+    std::vector<std::pair<std::string, std::string>> options;
+    if (config.HasMember("player") && config["player"].HasMember("mpv_options") &&
+        config["player"]["mpv_options"].IsObject()) {
+      for (const auto &option : config["player"]["mpv_options"].GetObject()) {
+        if (option.value.IsString()) {
+          options.emplace_back(option.name.GetString(), option.value.GetString());
+        }
+      }
+    }
+    return options;
+  }
+
+  std::string get_buffer_profile() const {
+    return get_string_value("player", "buffer_profile", "balanced");
+  }
+
   std::string get_audio_output() const {
 #ifdef _WIN32
     return get_mpv_option("ao", "wasapi");
@@ -4,8 +4,21 @@
 #include "../storage/localStorage.cpp"
 #include "../audio/player.cpp"
 #include "../storage/playlist_handler.cpp"
+#include "../storage/history_store.cpp"
+#include "../storage/track_journal.cpp"
 #include "../services/saavn/saavn.cpp"
 #include "../services/soundcloud/soundcloud.cpp"
+#include "../common/executor.hpp"
+#include "../common/latency_tracker.hpp"
+#include "../common/idle_state.hpp"
+#include "../common/lazy.hpp"
+#include "../audio/radio_extender.hpp"
+#include "../common/render_clock.hpp"
+#include "../ui/frame_scheduler.hpp"
+#include "../ui/ui_store.hpp"
+#include "../ui/virtual_list.hpp"
+#include "../ui/visualizer_view.hpp"
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <curl/curl.h>
@@ -19,6 +32,7 @@
 #include <ftxui/component/event.hpp>
 #include <ftxui/component/screen_interactive.hpp> // for ScreenInteractive
 #include <ftxui/screen/color.hpp>
+#include <ftxui/screen/terminal.hpp>
 #include <future>
 #include <iostream>
 #include <map>
@@ -41,10 +55,18 @@
 #include "../ai/json_output.hpp"
 #include "../ai/command_handler.hpp"
 #include "../ai/mcp_server.hpp"
+#include "../ai/control_socket.hpp"
 
 // Performance tuning constants
 namespace {
   constexpr size_t MAX_RECENT_TRACKS = 10;
+  constexpr size_t MAX_TOP_TRACKS = 50;
+
+  // xterm focus reporting (DECSET 1004): the terminal sends CSI I / CSI O
+  constexpr const char *kFocusReportingOn = "\x1b[?1004h";
+  constexpr const char *kFocusReportingOff = "\x1b[?1004l";
+  constexpr const char *kFocusIn = "\x1b[I";
+  constexpr const char *kFocusOut = "\x1b[O";
 }
 
 // Data in string to render in UI
@@ -60,8 +82,7 @@ std::vector<Track> track_data_saavn;
 std::vector<Track> track_data_lastfm;
 std::vector<Track> track_data_soundcloud;
 std::vector<Track> track_data_forestfm;
-std::vector<Track> next_tracks;
-std::vector<Track> recently_played;
+TrackList recently_played;
 std::vector<Track> trending_tracks;
 
 std::string current_track = "🎵TUISIC 🎵";
@@ -69,19 +90,16 @@ std::string current_artist = "Welcome back, User!";
 
 static std::atomic<bool> daemon_mode_active{false};
 
-// Playlist track index
-int current_track_index = 0;
-
 int selected_trending = 0;
 
-// Sources
-Lastfm lastfm;
-SoundCloud soundcloud;
-Saavn saavn;
-Justmusic justmusic;
+// Sources, each built the first time something asks it for tracks
+Lazy<Lastfm> lastfm;
+Lazy<SoundCloud> soundcloud;
+Lazy<Saavn> saavn;
+Lazy<Justmusic> justmusic;
 
-// Player instance
-auto player = std::make_shared<MusicPlayer>();
+// Player instance; mpv starts with the first call that needs it
+Lazy<MusicPlayer> player;
 
 // Playlist source
 enum class PlaylistSource { None, Search, ForestFM, ClassicFM };
@@ -90,6 +108,13 @@ PlaylistSource current_source = PlaylistSource::None;
 // Screen
 auto screen = ftxui::ScreenInteractive::Fullscreen();
 
+// Every background redraw request goes through here, so any number of
+// them within one frame cost a single render
+FrameScheduler frame_scheduler(30, [] { screen.PostEvent(ftxui::Event::Custom); });
+
+// Worker threads hand UI state changes to the UI thread through here
+UiStore ui_store(frame_scheduler);
+
 // Menu selection
 int selected = 0;
 int selectedd = 0;
@@ -139,13 +164,13 @@ auto searchQuery(const std::string &query) {
   
   // Capture query by value to ensure thread safety
   futures.push_back(std::async(std::launch::async, [query, &saavn]() { 
-    return saavn.fetch_tracks(query); 
+    return saavn->fetch_tracks(query); 
   }));
   futures.push_back(std::async(std::launch::async, [query, &lastfm]() { 
-    return lastfm.fetch_tracks(query); 
+    return lastfm->fetch_tracks(query); 
   }));
   futures.push_back(std::async(std::launch::async, [query, &soundcloud]() { 
-    return soundcloud.fetch_tracks(query); 
+    return soundcloud->fetch_tracks(query); 
   }));
   
   // Collect results
@@ -177,32 +202,17 @@ auto searchQuery(const std::string &query) {
   return track_strings;
 }
 
-auto fetch_recent() {
+auto fetch_recent(HistoryStore &history) {
   // Clear previous data
   recently_played_strings.clear();
   track_data.clear();
 
-  // Limit recently played to last MAX_RECENT_TRACKS unique tracks
-  // Use unordered_set for O(1) lookups instead of O(n) find_if
-  std::vector<Track> unique_recently_played;
-  std::unordered_set<std::string> seen_tracks;
-  unique_recently_played.reserve(MAX_RECENT_TRACKS); // Pre-allocate
-  
-  for (const auto &track : recently_played) {
-    std::string track_str = track.to_string(); // Call once instead of in loop
-    
-    // Check if this exact track is not already in unique list
-    if (seen_tracks.find(track_str) == seen_tracks.end()) {
-      seen_tracks.insert(track_str);
-      unique_recently_played.push_back(track);
-    }
-  }
-
-  // Keep only the last MAX_RECENT_TRACKS tracks
-  if (unique_recently_played.size() > MAX_RECENT_TRACKS) {
-    unique_recently_played = std::vector<Track>(
-        unique_recently_played.end() - MAX_RECENT_TRACKS, unique_recently_played.end());
-  }
+  // Last MAX_RECENT_TRACKS unique tracks, straight off the history's
+  // recency index
+  std::vector<Track> unique_recently_played =
+      history.recent_unique(MAX_RECENT_TRACKS);
+  // Oldest first, as the view always listed them
+  std::reverse(unique_recently_played.begin(), unique_recently_played.end());
 
   // Populate track_data and recently_played_strings
   track_data = unique_recently_played;
@@ -214,6 +224,18 @@ auto fetch_recent() {
   return recently_played_strings;
 }
 
+// This month's most played, with their play counts
+auto fetch_most_played(HistoryStore &history) {
+  track_data.clear();
+  std::vector<std::string> most_played_strings;
+  for (auto &stats : history.top_tracks_in_month(MAX_TOP_TRACKS)) {
+    most_played_strings.push_back(
+        fmt::format("{} ({} plays)", stats.track.to_string(), stats.plays));
+    track_data.push_back(std::move(stats.track));
+  }
+  return most_played_strings;
+}
+
 void switch_playlist_source(const std::vector<Track> &new_tracks) {
   // Stop current playback
   player->stop();
@@ -233,90 +255,15 @@ void switch_playlist_source(const std::vector<Track> &new_tracks) {
   }
 
   // Update UI
-  screen.PostEvent(ftxui::Event::Custom);
+  frame_scheduler.invalidate(FrameScheduler::List | FrameScheduler::Header);
 }
 
-#ifdef WITH_CAVA
-// Visualizer data storage
-std::vector<double> visualizer_bars;
-std::vector<double> smoothed_bars(16, 0.0);  // For smooth animations
-std::mutex visualizer_mutex;
-
-// Fixed number of bars like CAVA
-static constexpr int NUM_BARS = 16;
-
-// Visualizer component creator
+#ifdef WITH_VISUALIZER
+// Visualizer pane: as many bars as fit its width, drawn from the DSP
+// thread's latest levels. The player follows the count the pane reports.
 ftxui::Element create_visualizer_bars() {
-  using namespace ftxui;
-
-  std::lock_guard<std::mutex> lock(visualizer_mutex);
-
-  // Create fixed number of bars
-  std::vector<Element> bars;
-  const int MAX_HEIGHT = 8;  // Reduced height for better UI layout
-  const int BASE_HEIGHT = 1;  // Minimum bar height (base indicator)
-
-  // Always create exactly NUM_BARS bars
-  for (int bar_index = 0; bar_index < NUM_BARS; bar_index++) {
-    double target_height = BASE_HEIGHT;
-
-    // Get height from visualizer data if available
-    if (!visualizer_bars.empty() && bar_index * 2 < visualizer_bars.size()) {
-      // Average stereo channels
-      double value = (bar_index * 2 + 1 < visualizer_bars.size())
-                      ? (visualizer_bars[bar_index * 2] + visualizer_bars[bar_index * 2 + 1]) / 2.0
-                      : visualizer_bars[bar_index * 2];
-
-      // Reduced sensitivity like CAVA's down arrow (lower multiplier)
-      target_height = std::clamp(value * MAX_HEIGHT * 1.2, static_cast<double>(BASE_HEIGHT), static_cast<double>(MAX_HEIGHT));
-    }
-
-    // CAVA-style smoothing with gravity effect
-    // Fast rise, slow fall (like gravity)
-    if (target_height > smoothed_bars[bar_index]) {
-      // Rising: respond quickly (30% of the way)
-      smoothed_bars[bar_index] = smoothed_bars[bar_index] * 0.7 + target_height * 0.3;
-    } else {
-      // Falling: respond slowly (10% of the way) - gravity effect
-      smoothed_bars[bar_index] = smoothed_bars[bar_index] * 0.9 + target_height * 0.1;
-    }
-
-    int height = std::clamp(static_cast<int>(smoothed_bars[bar_index]), BASE_HEIGHT, MAX_HEIGHT);
-
-    // Create colored bar based on height
-    Color bar_color;
-    Color base_color = Color::GrayDark;  // Dim base color
-
-    if (height <= MAX_HEIGHT / 3) {
-      bar_color = Color::Green;
-    } else if (height <= (MAX_HEIGHT * 2) / 3) {
-      bar_color = Color::Yellow;
-    } else {
-      bar_color = Color::Red;
-    }
-
-    // Build vertical bar - always same structure, only height changes
-    // Use actual character width instead of size() modifier
-    std::vector<Element> bar_segments;
-    for (int h = 0; h < MAX_HEIGHT; h++) {
-      if (h < BASE_HEIGHT) {
-        // Base indicator (always visible) - wider with actual characters
-        bar_segments.push_back(text(" ▁▁") | color(base_color));
-      } else if (h < height) {
-        // Active part of the bar - wider with actual characters
-        bar_segments.push_back(text(" █") | color(bar_color));
-      } else {
-        // Empty space - same width
-        bar_segments.push_back(text("  "));
-      }
-    }
-
-    // Reverse so bars grow upward
-    std::reverse(bar_segments.begin(), bar_segments.end());
-    bars.push_back(vbox(std::move(bar_segments)));
-  }
-
-  return hbox(std::move(bars)) | center;
+  return visualizer_view(player->get_visualization_data(),
+                         [](int fit) { player->set_visualizer_bars(fit); });
 }
 #endif
 
@@ -334,63 +281,35 @@ std::unique_ptr<TUIDiscordIntegration> tui_discord;
 bool is_discord_active = false;
 
 // In TUI mode initialization:
-void setupMPRISForDaemon(std::shared_ptr<MusicPlayer> player,
-                         std::vector<Track> next_tracks,
-                         int current_track_index) {
+void setupMPRISForDaemon(std::shared_ptr<MusicPlayer> player) {
   mpris_handler = std::make_unique<MPRISHandler>(player);
   mpris_handler->initialize();
   //system("notify-send 'MPRIS integration initialized'");
   notifications::send("MPRIS integration initialized");
 
-
+  auto queue = player->get_queue();
   mpris_handler->setTrackCallbacks(
-      [&]() -> std::string {
-        return next_tracks.empty() ? "" : next_tracks[current_track_index].id;
-      },
-      [&]() -> std::string {
-        return next_tracks.empty() ? "" : next_tracks[current_track_index].name;
+      [queue]() -> std::string {
+        auto track = queue->current();
+        return track ? track->id : "";
       },
-      [&]() -> std::string {
-        return next_tracks.empty() ? ""
-                                  : next_tracks[current_track_index].artist;
+      [queue]() -> std::string {
+        auto track = queue->current();
+        return track ? track->name : "";
       },
-      [&]() {
-        // Update TUI state when next track is triggered via MPRIS
-        if (current_track_index < track_data.size() - 1) {
-          // current_track_index++;
-          // current_track_index = (current_track_index + 1) %
-          // track_data.size();
-
-          current_track_index = (current_track_index + 1) % next_tracks.size();
-          // screen.PostEvent(ftxui::Event::Custom);
-        }
-        // correct logic to next track:
-        //
-        //                                             current_track_name =
-        //                                             next_tracks[current_track_indexx-1].name;
-        //                                             current_track_artist =
-        //                                             next_tracks[current_track_indexx-1].artist;
-
-        current_track = next_tracks[current_track_index-1].name;
-        current_artist = next_tracks[current_track_index-1].artist;
-        // screen.PostEvent(ftxui::Event::Custom);
-        //       current_track_index = (current_track_index + 1) %
-        //       track_data.size();
-        // player->play(track_data[current_track_index].url);
-
-        // Trigger UI refresh if needed
+      [queue]() -> std::string {
+        auto track = queue->current();
+        return track ? track->artist : "";
       },
-      [&]() {
-        // Update TUI state when previous track is triggered via MPRIS
-        if (current_track_index > 0) {
-          // current_track_index--;
-          // current_track_index = (current_track_index - 1) %
-          // track_data.size();
-          current_track_index = (current_track_index - 1) % next_tracks.size();
-          // screen.PostEvent(ftxui::Event::Custom);
-        }
-      }
-      );
+      [queue]() {
+        // Keep the TUI header in sync when MPRIS skips
+        ui_store.post(FrameScheduler::Header, [queue] {
+          if (auto track = queue->current()) {
+            current_track = track->name;
+            current_artist = track->artist;
+          }
+        });
+      });
 
   mpris_handler->startEventLoop();
 }
@@ -404,9 +323,27 @@ int main(int argc, char *argv[]) {
 
   // AI/CLI Command Mode: tuisic --cmd "play jazz"
   if (argc >= 3 && std::string(argv[1]) == "--cmd") {
-    auto cmd_handler = std::make_shared<ai::CommandHandler>(player, soundcloud, saavn);
     std::string command = argv[2];
-    std::string result = cmd_handler->execute(command);
+    std::string result;
+    // A running instance answers in a few milliseconds; only without one
+    // does this process start its own player
+    switch (ai::send_command(command, result)) {
+    case ai::SendResult::Answered:
+      break;
+    case ai::SendResult::NoInstance: {
+      ai::CommandHandler cmd_handler(player, soundcloud, saavn);
+      result = cmd_handler.execute(command);
+      break;
+    }
+    case ai::SendResult::Failed:
+      // The instance may still carry it out; doing it here as well could
+      // start a second player
+      std::cout << ai::JsonOutput::create_error(
+                       "No reply from the running instance at " +
+                       ai::control_socket_path())
+                << std::endl;
+      return 1;
+    }
     std::cout << result << std::endl;
     return 0;
   }
@@ -419,33 +356,17 @@ int main(int argc, char *argv[]) {
     return 0;
   }
 
-#ifdef WITH_MPRIS
-      tui_mpris = std::make_unique<TUIMPRISIntegration>(track_data, next_tracks, current_track_index);
-      // tui_mpris->setup(player);
-#endif
-
-#ifdef WITH_DISCORD
-      tui_discord = std::make_unique<TUIDiscordIntegration>(track_data, next_tracks, current_track_index, player);
-      // Discord will be initialized when user starts playing
-#endif
-
   if (argc >= 3 && std::string(argv[1]) == "--daemon") {
-    auto player = std::make_shared<MusicPlayer>();
     std::string current_track_id = argv[2];
     std::string current_track_name = argv[3];
     std::string current_track_artist = argv[4];
     std::string current_track_url = argv[5];
-    auto next_tracks = saavn.fetch_next_tracks(current_track_id.c_str());
-    std::vector<std::string> next_track_urls;
-    next_track_urls.push_back(current_track_url);
-    for (const auto &track : next_tracks) {
-      next_track_urls.push_back(track.url);
-    }
-    player->create_playlist(next_track_urls);
+    auto next_tracks = saavn->fetch_next_tracks(current_track_id.c_str());
     // Create Track object for lyrics support
     Track current_track_obj{current_track_name, current_track_artist, current_track_url, current_track_id, "saavn"};
-    player->play(current_track_obj);
-    int current_track_indexx = player->get_current_playlist_index();
+    next_tracks.insert(next_tracks.begin(), current_track_obj);
+    player->load_queue(next_tracks);
+    auto queue = player->get_queue();
     // system(("notify-send 'Tuisic' 'Playing'" +
     //         std::to_string(current_track_indexx))
     //            .c_str());
@@ -464,7 +385,7 @@ int main(int argc, char *argv[]) {
       // Prevent division by zero and ensure valid percentage
       if (total_duration > 0) {
         progress_percentage = static_cast<int>((pos / dur) * 100.0);
-        screen.PostEvent(ftxui::Event::Custom);
+        frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
       }
     });
 
@@ -473,7 +394,7 @@ int main(int argc, char *argv[]) {
     auto connection = sdbus::createSessionBusConnection(serviceName);
     // connection->requestName(serviceName);
     sdbus::ObjectPath objectPath{"/org/mpris/MediaPlayer2"};
-    //setupMPRISForDaemon(player, next_tracks, current_track_indexx);
+    //setupMPRISForDaemon(player);
 
 
      auto object = sdbus::createObject(*connection, std::move(objectPath));
@@ -493,11 +414,12 @@ int main(int argc, char *argv[]) {
 
      auto getMetadata = [&]() -> std::map<std::string, sdbus::Variant> {
        std::map<std::string, sdbus::Variant> metadata;
-       metadata["mpris:trackid"] = sdbus::Variant(current_track_id);
-       metadata["xesam:title"] = sdbus::Variant(current_track_name);
+       auto track = queue->current();
+       metadata["mpris:trackid"] = sdbus::Variant(track ? track->id : "");
+       metadata["xesam:title"] = sdbus::Variant(track ? track->name : "");
        metadata["position"] = sdbus::Variant(int64_t(current_position * 1000000));
        metadata["xesam:artist"] =
-           sdbus::Variant(std::vector<std::string>{current_track_artist});
+           sdbus::Variant(std::vector<std::string>{track ? track->artist : ""});
        metadata["mpris:length"] =
            sdbus::Variant(int64_t(total_duration * 1000000)); // 3 minutes in microseconds
        return metadata;
@@ -556,9 +478,6 @@ int main(int argc, char *argv[]) {
                                              {},
                                              [&](sdbus::MethodCall call) {
                                                player->next_track();
-                                                 current_track_indexx = (current_track_indexx + 1) % next_tracks.size();
-                                                 current_track_name = next_tracks[current_track_indexx-1].name;
-                                                 current_track_artist = next_tracks[current_track_indexx-1].artist;
                                                updateMetadata();
                                                updatePlaybackStatus();
                                                auto reply = call.createReply();
@@ -637,20 +556,20 @@ int main(int argc, char *argv[]) {
                                      {}})
          .forInterface(interfaceName2);
 
-    player->set_end_of_track_callback([&] {
-      current_track_indexx = (current_track_indexx + 1) % next_tracks.size();
-      current_track_name = next_tracks[current_track_indexx-1].name;
-      current_track_artist = next_tracks[current_track_indexx-1].artist;
-    });
+    // Auto-advance moves the queue; republish metadata from it
+    queue->add_listener([&] { updateMetadata(); });
 
     // Run the I/O event loop on the bus connection.
-    std::thread([&connection] { connection->enterEventLoop(); }).detach();
+    std::thread bus_thread([&connection] { connection->enterEventLoop(); });
     updateMetadata();
     updatePlaybackStatus();
 
-    #endif
+    // The bus loop keeps the daemon alive
+    bus_thread.join();
+    #else
     // keep alive
     std::this_thread::sleep_for(std::chrono::hours(24 * 365));
+    #endif
     return 0;
   }
   curl_global_init(CURL_GLOBAL_ALL);
@@ -659,28 +578,58 @@ int main(int argc, char *argv[]) {
   // Initialize notification system with config
   notifications::init(config.get());
 
-#ifdef WITH_CAVA
-  // Set up audio callback for visualizer
-  player->set_audio_callback([&](const std::vector<double>& audio_data) {
-    static int ui_callback_count = 0;
-    ui_callback_count++;
+#ifdef WITH_MPRIS
+      tui_mpris = std::make_unique<TUIMPRISIntegration>(player->get_queue());
+      // tui_mpris->setup(player);
+#endif
 
-    if (ui_callback_count == 1) {
-      std::cout << "[Main] UI callback working! Received " << audio_data.size() << " bars" << std::endl;
-    }
+#ifdef WITH_DISCORD
+      tui_discord = std::make_unique<TUIDiscordIntegration>(player->get_queue(), player);
+      // Discord will be initialized when user starts playing
+#endif
 
-    std::lock_guard<std::mutex> lock(visualizer_mutex);
-    visualizer_bars = audio_data;
+  // Every play with its time, for the recent and most-played views
+  HistoryStore history(static_cast<size_t>(config->get_history_recent_limit()));
 
-    if (ui_callback_count % 100 == 0) {
-      std::cout << "[Main] UI updated " << ui_callback_count << " times, bars: " << visualizer_bars.size() << std::endl;
-    }
+  // Plays and favourites hit the disk as they happen, not only on 'q'
+  TrackJournal journal(recently_played, favorite_tracks, history,
+                       TrackJournal::parse_sync(config->get_journal_fsync()),
+                       config->get_journal_compact_every());
 
-    screen.PostEvent(ftxui::Event::Custom);
+  // `tuisic --cmd ...` from another terminal drives this instance. Its
+  // thread must not touch the bars' triple buffer, which the renderer reads.
+  player->claim_visualization_reader();
+  ai::CommandHandler remote_commands(player, soundcloud, saavn);
+  ai::ControlServer control_server([&remote_commands](const std::string &command) {
+    return remote_commands.execute(command);
   });
+  if (!control_server.start()) {
+    notifications::send("Remote control unavailable: " + control_server.last_error());
+  }
 
-  std::cout << "[Main] Audio callback set up successfully" << std::endl;
+#ifdef WITH_VISUALIZER
+  // Redraw the visualizer at a fixed rate, and only when the bars moved
+  uint64_t drawn_visualization = 0;
+  RenderClock visualizer_clock(
+      config->get_visualizer_fps(),
+      [&drawn_visualization] {
+        idle::coordinator().count(idle::Wakeup::ClockTick);
+        uint64_t version = player->get_visualization_version();
+        if (version == drawn_visualization) {
+          return false;
+        }
+        drawn_visualization = version;
+        return true;
+      },
+      [] { frame_scheduler.invalidate(FrameScheduler::Visualizer); });
+  // No ticks at all while paused, stopped or unfocused
+  idle::Subscription visualizer_idle = idle::coordinator().subscribe(
+      [&visualizer_clock](bool idle) { visualizer_clock.set_paused(idle); });
 #endif
+  idle::coordinator().enable_dump();
+  const bool idle_when_unfocused = config->get_idle_when_unfocused();
+  frame_scheduler.set_max_fps(config->get_max_fps());
+  const bool show_render_stats = config->get_show_render_stats();
 
   using namespace ftxui;
 
@@ -688,8 +637,6 @@ int main(int argc, char *argv[]) {
   std::string search_query;
   std::string current_album = "";
   std::string button_text = "Play";
-  std::mutex playlist_mutex;
-  std::vector<std::string> next_playlist;
 
   // Placeholder track list
   std::vector<std::string> tracks = {};
@@ -701,7 +648,6 @@ int main(int argc, char *argv[]) {
     current_album = "";
     button_text = "Play";
     selected = 0;
-    current_track_index = 0;
   };
 
   // for progress
@@ -712,7 +658,7 @@ int main(int argc, char *argv[]) {
 
   // std::vector<Element> trending_elements;
   // std::thread trending_thread([&]() {
-  //   trending_tracks = saavn.fetch_trending();
+  //   trending_tracks = saavn->fetch_trending();
   //   for (const auto &track : trending_tracks) {
   //     trending_track_strings.push_back(track.name);
   //   }
@@ -733,20 +679,48 @@ int main(int argc, char *argv[]) {
   // });
   // trending_thread.detach();
 
-  std::thread trending_thread([&]() {
-    trending_tracks = saavn.fetch_trending();
+  // Last session's lists paint the first frame; the fetches below swap
+  // fresh ones in when (and if) the network answers
+  SessionSnapshot session;
+  if (loadSession(session)) {
+    trending_tracks = std::move(session.trending);
     for (const auto &track : trending_tracks) {
       trending_track_strings.push_back(track.to_string());
     }
-    screen.PostEvent(Event::Custom);
+    home_track_data = std::move(session.home);
+    for (const auto &track : home_track_data) {
+      home_track_strings.push_back(track.to_string());
+    }
+    track_data = home_track_data;
+    track_strings = home_track_strings;
+    tracks = home_track_strings;
+    search_query = session.query;
+  }
+
+  tasks::shared().submit(tasks::Lane::Prefetch, [&](const tasks::CancelToken &token) {
+    auto fetched = saavn->fetch_trending();
+    // Offline: keep showing the stale list rather than an empty one
+    if (token.cancelled() || fetched.empty()) {
+      return;
+    }
+    std::vector<std::string> strings;
+    strings.reserve(fetched.size());
+    for (const auto &track : fetched) {
+      strings.push_back(track.to_string());
+    }
+    ui_store.post(FrameScheduler::List, [fetched = std::move(fetched),
+                                         strings = std::move(strings)]() mutable {
+      trending_tracks = std::move(fetched);
+      trending_track_strings = std::move(strings);
+    });
   });
-  trending_thread.detach();
 
   // Components
   Component input_search = Input(&search_query, "Search for music...");
   input_search = Input(&search_query, "Search for music...") |
                  CatchEvent([&tracks, &search_query](Event event) {
                    if (event == Event::Return) {
+                     favorites_listed = false;
                      tracks = searchQuery(search_query);
                      return true;
                    }
@@ -756,10 +730,21 @@ int main(int argc, char *argv[]) {
   std::vector<std::string> test_track = {"Track 1", "Track 2", "Track 3"};
   auto menu2 = Menu(&test_track, &selectedd, MenuOption::Horizontal());
 
-  auto menu = Menu(&tracks, &selected);
-  menu =
-      Menu(&tracks, &selected) |
-      CatchEvent([&button_text, &next_playlist, &playlist_mutex, &config,
+  // History, favourites and search share this list; only the rows in view
+  // are built, however long it gets
+  // Favourites carry a marker in the track list
+  VirtualListOption track_list_option;
+  track_list_option.marked = [](int index) {
+    return index < static_cast<int>(track_data.size()) &&
+           isFavorite(track_data[index]);
+  };
+  // Favourites are listed a page at a time
+  track_list_option.fill = [&tracks](int rows) {
+    more_favorites(track_data, tracks, static_cast<size_t>(rows));
+  };
+  auto menu =
+      VirtualList(&tracks, &selected, track_list_option) |
+      CatchEvent([&button_text, &config, &journal,
                   argv](Event event) {
         if (event == Event::Return) {
           // std::cerr << "Selected: " << selected << std::endl;
@@ -770,29 +755,32 @@ int main(int argc, char *argv[]) {
             }
             /* player->stop(); */
             /* player->play(track_data[selected].url); */
-            recently_played.push_back(track_data[selected]);
             current_track = track_data[selected].name;
             current_artist = track_data[selected].artist;
             button_text = "Pause";
-            screen.PostEvent(Event::Custom);
+            frame_scheduler.invalidate(FrameScheduler::All);
+            latency::tracker().begin();
 
             if (track_data[selected].id != "") {
 
-              std::thread next_tracks_thread([&]() {
+              // Rapid Enter presses only keep the newest selection alive
+              tasks::shared().submit_latest(tasks::Lane::UiCritical, "next_tracks",
+                                            [&, selected_track = track_data[selected]](const tasks::CancelToken &token) {
                 try {
                   /* std::cerr << "Fetttchiing nextttttttttttttt"; */
                   // system(("notify-send 'Tuisic' " + track_data[selected].id +
                   //         track_data[selected].url)
                   //            .c_str());
-                if(track_data[selected].source=="lastfm"){
-                    player->play(track_data[selected]);
+                if(selected_track.source=="lastfm"){
+                    player->play(selected_track);
                     return;
                 }
-                if(track_data[selected].source=="soundcloud"){
-                    next_tracks = soundcloud.fetch_next_tracks(track_data[selected].url);
+                std::vector<Track> fetched;
+                if(selected_track.source=="soundcloud"){
+                    fetched = soundcloud->fetch_next_tracks(selected_track.url);
                 }else {//if(track_data[selected].source=="saavn"){
                     // system(("notify-send 'Tuisic' 'Fetching next'" + track_data[selected].id).c_str());
-                    next_tracks = saavn.fetch_next_tracks(track_data[selected].id);
+                    fetched = saavn->fetch_next_tracks(selected_track.id);
                     // system(("notify-send 'Tuisic' 'Fetching next'" + next_tracks[0].id).c_str());
 
                 }
@@ -801,26 +789,19 @@ int main(int argc, char *argv[]) {
                 // }
 
                   // next_tracks =
-                  //     saavn.fetch_next_tracks(track_data[selected].id);
+                  //     saavn->fetch_next_tracks(track_data[selected].id);
                   // if (next_tracks.empty()) {
                   //   system(("notify-send 'Tuisic' 'No next track available'" + track_data[selected].url).c_str());
                   //   player->play(track_data[selected].url);
                   //   return;
                   // }
-                  std::vector<std::string> next_track_urls;
-                  next_track_urls.push_back(track_data[selected].url);
-                  for (const auto &track : next_tracks) {
-                    next_track_urls.push_back(track.url);
-                  }
-                  next_tracks.insert(next_tracks.begin(), track_data[selected]);
-
-                  {
-                    std::lock_guard<std::mutex> lock(playlist_mutex);
-                    next_playlist = next_track_urls;
+                  if (token.cancelled()) {
+                    return; // superseded by a newer selection
                   }
-                  player->create_playlist(next_track_urls);
-                  current_track_index = 0;
-                  player->play(next_tracks[0]);
+                  latency::tracker().mark(latency::Stage::RecoFetch);
+                  fetched.insert(fetched.begin(), selected_track);
+                  player->load_queue(fetched);
+                  latency::tracker().mark(latency::Stage::CreatePlaylist);
 
 
                 #ifdef WITH_MPRIS
@@ -842,16 +823,15 @@ int main(int argc, char *argv[]) {
                   }
                 #endif
 
-                  screen.PostEvent(Event::Custom);
+                  frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::List);
                 } catch (const std::exception &e) {
                   // std::cerr << e.what() << std::endl;
                     notifications::send("Error: " + std::string(e.what()));
                 }
               });
-              next_tracks_thread.detach();
             } else {
-              // Track has no ID - play directly without fetching next tracks
-              player->play(track_data[selected].url);
+              // Track has no ID - queue the results without fetching next tracks
+              player->load_queue(track_data, selected);
 #ifdef WITH_MPRIS
               if(!is_mpris_active){
                   tui_mpris->setup(player);
@@ -900,21 +880,21 @@ int main(int argc, char *argv[]) {
         }
         if (event == Event::Character('L')) {
           player->toggle_subtitles();
-          screen.PostEvent(Event::Custom); // Refresh UI to show/hide subtitle section
+          frame_scheduler.invalidate(FrameScheduler::Lyrics); // Refresh UI to show/hide subtitle section
           return true;
         }
 
         if (event == Event::Character('a')) {
           if (selected >= 0 && selected < track_data.size()) {
-            if (!isFavorite(track_data[selected].name)) {
-              favorite_tracks.push_back(track_data[selected]);
+            if (journal.record_favorite(track_data[selected], true)) {
+              frame_scheduler.invalidate(FrameScheduler::List);
             }
           }
         }
 
         if (event == Event::Character('d')) {
           if (selected >= 0 && selected < track_data.size()) {
-            std::string current_song = track_data[selected].name + ".mp3";
+            std::string current_song = track_data[selected].name;
             /* std::string current_song = player->get_current_track(); */
             std::replace(current_song.begin(), current_song.end(), '/', '_');
             std::replace(current_song.begin(), current_song.end(), '\\', '_');
@@ -986,11 +966,11 @@ int main(int argc, char *argv[]) {
             if (!track_data_forestfm.empty()) {
               player->stop();
             }
-            player->play(trending_tracks[selected_trending].url);
+            // As a queue of one, so it is counted like any other play
+            player->play(trending_tracks[selected_trending]);
             current_track = trending_tracks[selected_trending].name;
             current_artist = trending_tracks[selected_trending].artist;
             button_text = "Pause";
-            recently_played.push_back(trending_tracks[selected_trending]);
 #ifdef WITH_MPRIS
             if(!is_mpris_active){
                 tui_mpris->setup(player);
@@ -1009,7 +989,7 @@ int main(int argc, char *argv[]) {
                 tui_discord->notifyTrackChange();
             }
 #endif
-            screen.PostEvent(Event::Custom);
+            frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::List);
           }
           return true;
         }
@@ -1033,7 +1013,9 @@ int main(int argc, char *argv[]) {
             player->pause();
             button_text = "Play";
           } else {
-            player->play(track_data_forestfm[current_track_index].url);
+            if (auto track = player->get_queue()->current()) {
+              player->play(track->url);
+            }
             button_text = "Pause";
           }
         } else if (current_source == PlaylistSource::Search) {
@@ -1043,7 +1025,11 @@ int main(int argc, char *argv[]) {
             if (!track_data_forestfm.empty()) {
               player->stop();
             }
-            player->play(track_data[selected].url);
+            if (player->get_current_track() == track_data[selected].url) {
+              player->resume();
+            } else {
+              player->load_queue(track_data, selected);
+            }
             current_artist = track_data[selected].artist;
             current_track = track_data[selected].name;
             button_text = "Pause";
@@ -1051,13 +1037,13 @@ int main(int argc, char *argv[]) {
         } else {
           if (selected >= 0 && selected < track_data.size()) {
             current_source = PlaylistSource::Search;
-            player->play(track_data[selected].url);
+            player->load_queue(track_data, selected);
             current_track = track_data[selected].name;
             current_artist = track_data[selected].artist;
             button_text = "Pause";
           }
         }
-        screen.PostEvent(Event::Custom);
+        frame_scheduler.invalidate(FrameScheduler::All);
       },
       ButtonOption::Animated(Color::Default, Color::GrayDark, Color::Default,
                              Color::White));
@@ -1087,25 +1073,25 @@ int main(int argc, char *argv[]) {
 
         // Reset track information
         current_track = "Fetching tracks...";
-        screen.PostEvent(Event::Custom);
+        frame_scheduler.invalidate(FrameScheduler::Header);
 
-        // Consider using a separate thread for fetching
-        std::thread fetch_thread([&]() {
-          is_fetching = true;
+        is_fetching = true;
+        bool queued = tasks::shared().submit(tasks::Lane::UiCritical, [&](const tasks::CancelToken &token) {
           try {
-            track_data_forestfm = justmusic.getMP3URL();
-
-            // Assuming you have a way to queue events or update on the main
-            // thread
-            current_track = track_data_forestfm.empty() ? "No tracks found"
-                                                        : "Tracks fetched";
-
+            auto fetched = justmusic->getMP3URL();
+            if (token.cancelled()) {
+              is_fetching = false;
+              return;
+            }
             is_fetching = false;
-            if (!track_data_forestfm.empty()) {
-              // Create playlist of URLs
-              std::vector<std::string> track_urls;
-              for (const auto &track : track_data_forestfm) {
-                track_urls.push_back(track.url);
+
+            // Everything the UI shows changes on the UI thread
+            ui_store.post(FrameScheduler::Header | FrameScheduler::List,
+                          [&, fetched = std::move(fetched)]() mutable {
+              track_data_forestfm = std::move(fetched);
+              if (track_data_forestfm.empty()) {
+                current_track = "No tracks found";
+                return;
               }
               current_album = track_data_forestfm[0].name;
 
@@ -1114,25 +1100,27 @@ int main(int argc, char *argv[]) {
                 player->stop(); // Complete stop instead of just pausing
               }
 
-              // Create playlist and start playing
-              player->create_playlist(track_urls);
-              current_track_index = 0;
+              // Queue the station and start playing
+              player->load_queue(track_data_forestfm);
               button_text_forestfm = "❚❚";
               current_source = PlaylistSource::ForestFM;
 
               // Update current track info
               current_track = track_data_forestfm[0].name;
               current_artist = track_data_forestfm[0].artist;
-              player->play(track_data_forestfm[0]);
               button_text = "Pause";
-            }
-            screen.PostEvent(Event::Custom);
+            });
           } catch (const std::exception &e) {
-            current_track = "Error fetching tracks: " + std::string(e.what());
-            screen.PostEvent(Event::Custom);
+            is_fetching = false;
+            ui_store.post(FrameScheduler::Header,
+                          [message = std::string(e.what())] {
+              current_track = "Error fetching tracks: " + message;
+            });
           }
         });
-        fetch_thread.detach(); // Allow thread to run independently
+        if (!queued) {
+          is_fetching = false;
+        }
       },
       ButtonOption::Animated(Color::Default, Color::GrayDark, Color::Default,
                              Color::White));
@@ -1144,11 +1132,13 @@ int main(int argc, char *argv[]) {
                              Color::White));
 
   std::vector<std::string> playlist_items = {"Home", "Recently Played",
-                                             "Favorites", "CustomPlaylist"};
+                                             "Favorites", "Most Played",
+                                             "CustomPlaylist"};
   int selected_playlist = 0;
   auto playlist_menu =
       Menu(&playlist_items, &selected_playlist) | CatchEvent([&](Event event) {
         if (event == Event::Return) {
+          favorites_listed = false; // set again if favourites are picked
           if (selected_playlist == 0) {
             // current_source = PlaylistSource::Favorites;
             current_track = "Home";
@@ -1161,7 +1151,7 @@ int main(int argc, char *argv[]) {
             current_track = "Recently Played";
             home_track_strings = tracks;
             tracks.clear();
-            tracks = fetch_recent();
+            tracks = fetch_recent(history);
           } else if (selected_playlist == 2) {
             // current_source = PlaylistSource::Custom;
             if (!(home_track_strings.size() > 0)) {
@@ -1171,10 +1161,17 @@ int main(int argc, char *argv[]) {
             tracks.clear();
             tracks = fetch_favorites(track_data);
           } else if (selected_playlist == 3) {
+            if (!(home_track_strings.size() > 0)) {
+              home_track_strings = tracks;
+            }
+            current_track = "Most Played This Month";
+            tracks.clear();
+            tracks = fetch_most_played(history);
+          } else if (selected_playlist == 4) {
             // current_source = PlaylistSource::Custom;
             current_track = "Custom Playlist";
           }
-          screen.PostEvent(Event::Custom);
+          frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::List);
           return true;
         }
         return false;
@@ -1194,29 +1191,68 @@ int main(int argc, char *argv[]) {
       tui_discord->notifyPlaybackChange();
     }
 #endif
-    screen.PostEvent(Event::Custom);
+    frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
   });
   double current_position = 0.0;
   double total_duration = 0.0;
   int progress_percentage = 0;
 
-  // Update the time callback to correctly calculate progress
-  player->set_time_callback([&](double pos, double dur) {
-    current_position = pos;
-    total_duration = dur;
-
+  // Positions arrive on mpv's thread and only the latest matters, so at
+  // most one update waits in the UI store at a time
+  std::atomic<double> reported_position{0.0};
+  std::atomic<double> reported_duration{0.0};
+  std::atomic<bool> position_queued{false};
+  auto apply_position = [&] {
+    position_queued = false;
+    current_position = reported_position.load(std::memory_order_relaxed);
+    total_duration = reported_duration.load(std::memory_order_relaxed);
     // Prevent division by zero and ensure valid percentage
     if (total_duration > 0) {
-      progress_percentage = static_cast<int>((pos / dur) * 100.0);
-      screen.PostEvent(Event::Custom);
+      progress_percentage =
+          static_cast<int>((current_position / total_duration) * 100.0);
+    }
+  };
+
+  // The header shows whole seconds and the bar whole percent; mpv reports
+  // time-pos tens of times a second. Only a change in what is shown asks
+  // for a frame. Touched by the mpv event thread only.
+  struct {
+    int64_t position = -1;
+    int64_t duration = -1;
+    int percent = -1;
+  } shown_time;
+
+  // Update the time callback to correctly calculate progress
+  player->set_time_callback([&](double pos, double dur) {
+    reported_position.store(pos, std::memory_order_relaxed);
+    reported_duration.store(dur, std::memory_order_relaxed);
+    int64_t position = static_cast<int64_t>(std::floor(pos));
+    int64_t duration = static_cast<int64_t>(std::floor(dur));
+    int percent = dur > 0 ? static_cast<int>((pos / dur) * 100.0) : 0;
+    if (position == shown_time.position && duration == shown_time.duration &&
+        percent == shown_time.percent) {
+      return;
+    }
+    shown_time = {position, duration, percent};
+    if (position_queued.exchange(true)) {
+      return;
+    }
+    // While idle the new position shows with the next input-driven redraw
+    if (dur > 0 && !idle::coordinator().is_idle()) {
+      ui_store.post(FrameScheduler::Header | FrameScheduler::Progress,
+                    apply_position);
+    } else {
+      ui_store.defer(FrameScheduler::Header | FrameScheduler::Progress,
+                     apply_position);
     }
   });
 
   std::string current_subtitle_text = "No subtitle";
   player->set_subtitle_callback([&](const std::string &subtitle) {
     // Update your UI with the subtitle
-    current_subtitle_text = subtitle;
-    screen.PostEvent(Event::Custom); // Trigger screen update
+    idle::coordinator().count(idle::Wakeup::Redraw);
+    ui_store.post(FrameScheduler::Lyrics,
+                  [&, subtitle] { current_subtitle_text = subtitle; });
   });
 
   Component progress_slider = Slider("", &progress_percentage, 0, 100, 1);
@@ -1233,115 +1269,69 @@ int main(int argc, char *argv[]) {
   });
 
   auto button_prev = Button("<-", [&] {
-    if (current_source == PlaylistSource::ForestFM &&
-        !track_data_forestfm.empty()) {
-      current_track_index =
-          (current_track_index - 1 + track_data_forestfm.size()) %
-          track_data_forestfm.size();
-      player->play(track_data_forestfm[current_track_index].url);
-
-      current_track = track_data_forestfm[current_track_index].name;
-      current_artist = track_data_forestfm[current_track_index].artist;
-      button_text = "Pause";
-    } else if (current_source == PlaylistSource::Search &&
-               !track_data.empty()) {
-      player->previous_track(track_data, selected);
-
-      current_track = track_data[selected].name;
-      current_artist = track_data[selected].artist;
+    if (!player->get_queue()->empty()) {
+      player->previous_track();
       button_text = "Pause";
     }
 
+    // Track metadata follows the queue listeners; only play state is ours
 #ifdef WITH_MPRIS
     if (is_mpris_active && tui_mpris) {
-      tui_mpris->notifyTrackChange();
       tui_mpris->notifyPlaybackChange();
     }
 #endif
 
-#ifdef WITH_DISCORD
-    if (is_discord_active && tui_discord) {
-      tui_discord->notifyTrackChange();
-    }
-#endif
-
-    screen.PostEvent(Event::Custom);
+    frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
   });
 
   auto button_next = Button("->", [&] {
-    if (current_source == PlaylistSource::ForestFM &&
-        !track_data_forestfm.empty()) {
-      current_track_index =
-          (current_track_index + 1) % track_data_forestfm.size();
-      player->play(track_data_forestfm[current_track_index]);
-
-      current_track = track_data_forestfm[current_track_index].name;
-      current_artist = track_data_forestfm[current_track_index].artist;
-      button_text = "Pause";
-    } else if (current_source == PlaylistSource::Search &&
-               !track_data.empty()) {
-      player->next_track(track_data, selected);
-
-      current_track = track_data[selected].name;
-      current_artist = track_data[selected].artist;
+    if (!player->get_queue()->empty()) {
+      player->next_track();
       button_text = "Pause";
     }
 
+    // Track metadata follows the queue listeners; only play state is ours
 #ifdef WITH_MPRIS
     if (is_mpris_active && tui_mpris) {
-      tui_mpris->notifyTrackChange();
       tui_mpris->notifyPlaybackChange();
     }
 #endif
 
-#ifdef WITH_DISCORD
-    if (is_discord_active && tui_discord) {
-      tui_discord->notifyTrackChange();
-    }
-#endif
+    frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
+  });
 
-    screen.PostEvent(Event::Custom);
+  // Header and play history follow the queue, whoever moved it: Enter,
+  // keys, auto-advance, radio top-ups, MPRIS, the control socket. The
+  // current track is taken here, so quick skips each count once; it is
+  // recorded on the UI thread, which owns the journal.
+  TrackHandle last_recorded;
+  player->get_queue()->add_listener([&] {
+    TrackHandle track = player->get_queue()->current();
+    ui_store.post(FrameScheduler::Header | FrameScheduler::List,
+                  [&, track] {
+      if (!track) {
+        return;
+      }
+      current_track = track->name;
+      current_artist = track->artist;
+      if (track != last_recorded) { // appends and shuffle keep the handle
+        last_recorded = track;
+        journal.record_play(*track);
+      }
+    });
   });
 
-  player->set_end_of_track_callback([&] {
-    // Automatically update track info when a track ends
-    if (!next_tracks.empty()) {
-      /* current_track_index = player->get_current_playlist_index(); */
-      // std::cerr << next_tracks.size() << std::endl;
-      current_track_index = (current_track_index + 1) % next_tracks.size();
-      current_track = next_tracks[current_track_index].name;
-      current_artist = next_tracks[current_track_index].artist;
-      player->next_track(next_tracks, current_track_index);
-    } else if (!track_data_forestfm.empty()) {
-      current_track_index =
-          (current_track_index + 1) % track_data_forestfm.size();
-      current_track = track_data_forestfm[current_track_index].name;
-      current_artist = track_data_forestfm[current_track_index].artist;
-    } else if (!track_data.empty()) {
-      selected = (selected + 1) % track_data.size();
-      current_track = track_data[selected].name;
-      current_artist = track_data[selected].artist;
+  // Radio mode: top the queue up from the recommendation APIs
+  RadioExtender radio(player->get_queue(), [](const Track &seed) {
+    if (seed.source == "soundcloud") {
+      return soundcloud->fetch_next_tracks(seed.url);
     }
-
-#ifdef WITH_MPRIS
-    if (is_mpris_active && tui_mpris) {
-      tui_mpris->notifyTrackChange();
-      tui_mpris->notifyPlaybackChange();
+    if (seed.source == "saavn" && !seed.id.empty()) {
+      return saavn->fetch_next_tracks(seed.id);
     }
-#endif
-
-#ifdef WITH_DISCORD
-    if (is_discord_active && tui_discord) {
-      tui_discord->notifyTrackChange();
-    }
-#endif
-
-    // Ensure UI updates
-    screen.PostEvent(Event::Custom);
-
-    // Continue playback
-    /* player->next_track(track_data, selected); */
+    return std::vector<Track>{};
   });
+  radio.set_enabled(config->get_radio_enabled());
 
   // Component tree
   auto component = Container::Vertical({
@@ -1377,6 +1367,21 @@ int main(int argc, char *argv[]) {
 
   component =
       component | CatchEvent([&](Event event) {
+        // Input renders anyway and may change any region
+        if (!(event == Event::Custom)) {
+          frame_scheduler.touch(FrameScheduler::All);
+        }
+
+        // Terminal focus reports (enabled around screen.Loop below)
+        if (event == Event::Special(kFocusIn) ||
+            event == Event::Special(kFocusOut)) {
+          bool focused = event == Event::Special(kFocusIn);
+          if (idle_when_unfocused) {
+            idle::coordinator().set(idle::Unfocused, !focused);
+          }
+          return true;
+        }
+
         // Check if search input is focused
         bool is_search_focused = input_search->Focused();
 
@@ -1419,15 +1424,14 @@ int main(int argc, char *argv[]) {
                 button_text = "Play";
                 button_text_forestfm = "▶";
               } else {
-                player->play(track_data_forestfm[current_track_index].url);
-                current_track = track_data_forestfm[current_track_index].name;
-                current_artist =
-                    track_data_forestfm[current_track_index].artist;
+                if (auto track = player->get_queue()->current()) {
+                  player->play(track->url);
+                }
                 button_text = "Pause";
                 button_text_forestfm = "❚❚";
               }
             }
-            screen.PostEvent(Event::Custom);
+            frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
             return true;
           }
 
@@ -1442,61 +1446,25 @@ int main(int argc, char *argv[]) {
           }
 
           if (event == Event::Character('>')) { // Next track
-            if (!next_tracks.empty()) {
-              /* current_track_index = player->get_current_playlist_index(); */
-              // std::cerr << next_tracks.size() << std::endl;
-              current_track_index =
-                  (current_track_index + 1) % next_tracks.size();
-              current_track = next_tracks[current_track_index].name;
-              current_artist = next_tracks[current_track_index].artist;
-              player->next_track(next_tracks, current_track_index);
-            } else if (!track_data_forestfm.empty()) {
-              current_track_index =
-                  (current_track_index + 1) % track_data_forestfm.size();
-              current_track = track_data_forestfm[current_track_index].name;
-              current_artist = track_data_forestfm[current_track_index].artist;
-            } else if (!track_data.empty()) {
-              selected = (selected + 1) % track_data.size();
-              current_track = track_data[selected].name;
-              current_artist = track_data[selected].artist;
-            }
-
-            // Ensure UI updates
-            screen.PostEvent(Event::Custom);
+            player->next_track();
+            frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
           }
           if (event == Event::Character('<')) { // Previous track
-            if (!next_tracks.empty()) {
-              /* current_track_index = player->get_current_playlist_index(); */
-              // std::cerr << next_tracks.size() << std::endl;
-              current_track_index =
-                  (current_track_index - 1) % next_tracks.size();
-              current_track = next_tracks[current_track_index].name;
-              current_artist = next_tracks[current_track_index].artist;
-              player->next_track(next_tracks, current_track_index);
-            } else if (!track_data_forestfm.empty()) {
-              current_track_index =
-                  (current_track_index - 1) % track_data_forestfm.size();
-              current_track = track_data_forestfm[current_track_index].name;
-              current_artist = track_data_forestfm[current_track_index].artist;
-            } else if (!track_data.empty()) {
-              selected = (selected - 1) % track_data.size();
-              current_track = track_data[selected].name;
-              current_artist = track_data[selected].artist;
-            }
-            screen.PostEvent(Event::Custom);
+            player->previous_track();
+            frame_scheduler.invalidate(FrameScheduler::Header | FrameScheduler::Progress);
           }
 
           if (event == Event::Character('+') ||
               event == Event::Character('=')) {
             volume = std::min(100, volume + 5);
             player->set_volume(volume);
-            screen.PostEvent(Event::Custom);
+            frame_scheduler.invalidate(FrameScheduler::Volume);
             return true;
           }
           if (event == Event::Character('-')) {
             volume = std::max(0, volume - 5);
             player->set_volume(volume);
-            screen.PostEvent(Event::Custom);
+            frame_scheduler.invalidate(FrameScheduler::Volume);
             return true;
           }
           if (event == Event::Character('m')) { // Mute toggle
@@ -1508,7 +1476,11 @@ int main(int argc, char *argv[]) {
               volume = previous_volume;
             }
             player->set_volume(volume);
-            screen.PostEvent(Event::Custom);
+            frame_scheduler.invalidate(FrameScheduler::Volume);
+            return true;
+          }
+          if (event == Event::Character('R')) { // Radio toggle
+            notifications::send(radio.toggle() ? "Radio on" : "Radio off");
             return true;
           }
 
@@ -1517,142 +1489,181 @@ int main(int argc, char *argv[]) {
 
         // Global quit shortcut
         if (event == Event::Character('q')) {
-          saveData(recently_played, favorite_tracks);
+          // The journal already has this session; compaction runs on its own
+          journal.flush();
           screen.Exit();
           return true;
         }
 
         // Escape to unfocus search box
         if (event == Event::Escape) {
-          screen.PostEvent(Event::Custom);
+          frame_scheduler.invalidate(FrameScheduler::List);
           return true;
         }
 
         return false;
       });
 
-  // Data Persistence
-  loadData(recently_played, favorite_tracks);
+  // Data Persistence: last snapshot plus the journal written since
+  journal.recover();
+  history.import_legacy(recently_played);
   std::vector<Element> smoe;
 
+  // Region trees kept between frames; only the dirty ones are rebuilt.
+  // The playlists and transport regions hold ButtonOption::Animated
+  // buttons, whose transitions advance in FTXUI animation frames that
+  // mark nothing dirty, so those two are built every frame instead.
+  CachedRegion header_region, visualizer_region, volume_region, list_region,
+      lyrics_region;
+
   // Layout
   auto renderer = Renderer(component, [&] {
+    // Pending deltas first: they mark the regions they change
+    ui_store.drain();
+    unsigned dirty = frame_scheduler.begin_frame();
+    // Sidebar (and with it the visualizer) grows on wide terminals: 16
+    // bars at the narrowest (32 columns inside the border), 32 from 66
+    int sidebar_width = std::clamp(Terminal::Size().dimx / 5, 34, 68);
+
+    Element header = header_region.get(dirty, FrameScheduler::Header, [&] {
+      return hbox({text(" λ ") | bgcolor(Color::Blue) | color(Color::White),
+                   text(" 🎵" + current_track + " 🎵") | bold | center,
+                   text(" " + current_artist + " ") | dim | center, filler(),
+                   text(fmt::format(" {} | {} ", format_time(current_position),
+                                    format_time(total_duration))) |
+                       border}) |
+             bold;
+    });
+
+    Element playlists = vbox({
+        // text("Library") | bold,
+        vbox({
+            text("Playlists: ") | bold, separator(),
+            playlist_menu->Render(),
+            // }) | border,
+        }),
+        separator(),
+        hbox({
+            play_forestfm->Render() | size(WIDTH, EQUAL, 5) | bold | center,
+            text("Forest FM") | bold | center,
+        }) | center,
+        separator(),
+        hbox({
+            play_classic->Render() | size(WIDTH, EQUAL, 5) | bold | center,
+            text("ClassicFM") | bold | center,
+        }) | center,
+    });
+
+    Element visualizer =
+        visualizer_region.get(dirty, FrameScheduler::Visualizer, [&]() -> Element {
+    #ifdef WITH_VISUALIZER
+          // Spans the whole column so the bar count follows its width
+          if (player->has_visualizer()) {
+            return create_visualizer_bars();
+          }
+    #endif
+          // Fetch the ASCII art for testing
+          auto art = get_track_ascii_art({});
+          // Convert each line into an FTXUI Element
+          std::vector<Element> art_elements;
+          for (const auto &line : art) {
+            art_elements.push_back(text(line) | color(Color::Blue));
+          }
+          return vbox(std::move(art_elements)) | center;
+        });
+
+    Element volume_bar = volume_region.get(dirty, FrameScheduler::Volume, [&] {
+      return hbox({
+          text("♪ ") | color(Color::Blue),
+          volume_slider->Render(),
+      });
+      //////// Volume slider with %
+      ///////////////////////////////////////
+      // hbox({
+      //     text("🔊 ") | color(Color::Blue),
+      //     volume_slider->Render() | flex,
+      //     text(std::to_string(volume) + "%") | size(WIDTH, EQUAL,
+      //     4),
+      // }) | size(HEIGHT, EQUAL, 1),
+      /////////////////////////////////////////////////////////////////
+    });
+
+    Element lists = list_region.get(dirty, FrameScheduler::List, [&] {
+      return vbox({
+          hbox({
+              text("Search: ") | bold,
+              input_search->Render(),
+          }) | border,
+          separator(),
+          text("Available Tracks:") | bold,
+          /* menu->Render() | frame | flex, */
+          hbox(
+              {vbox({
+                   menu->Render() | size(HEIGHT, EQUAL, 22) |
+                       size(WIDTH, EQUAL, 90),
+               }),
+               separator(),
+               /* vbox({ */
+               /*      menu2->Render(), */
+               /* }), */
+               vbox({hbox({
+                         filler(),
+                         text(" Trendings ") | bold | color(Color::White),
+                         filler(),
+                     }),
+                     separator(), trending_menu->Render() | frame}) |
+                   vscroll_indicator | yframe | flex |
+                   size(HEIGHT, EQUAL, 22)}),
+      });
+    });
+
+    // Conditionally render subtitle section based on toggle state
+    Element lyrics = lyrics_region.get(dirty, FrameScheduler::Lyrics, [&] {
+      return (player->are_subtitles_enabled() && !current_subtitle_text.empty()) ?
+        vbox({
+          hbox({
+            text("Subtitle: ") | bold | color(Color::LightSkyBlue1),
+            text(current_subtitle_text),
+          }),
+          separator(),
+        }) : vbox({
+              separator(),
+            });
+    });
+
+    Element controls = vbox({
+        hbox({
+            progress_slider->Render() | flex,
+        }),
+        hbox({
+            filler(),
+            button_prev->Render(),
+            play_button->Render(),
+            button_next->Render(),
+            filler(),
+        }) | center,
+    });
+
     return vbox({
-        hbox({text(" λ ") | bgcolor(Color::Blue) | color(Color::White),
-              text(" 🎵" + current_track + " 🎵") | bold | center,
-              text(" " + current_artist + " ") | dim | center, filler(),
-              text(fmt::format(" {} | {} ", format_time(current_position),
-                               format_time(total_duration))) |
-                  border}) |
-            bold,
+        header,
         separator(),
         filler(),
         hbox({
             vbox({
-                // text("Library") | bold,
-                vbox({
-                    text("Playlists: ") | bold, separator(),
-                    playlist_menu->Render(),
-                    // }) | border,
-                }),
-                separator(),
-                hbox({
-                    play_forestfm->Render() | size(WIDTH, EQUAL, 5) | bold |
-                        center,
-                    text("Forest FM") | bold | center,
-                }) | center,
+                playlists,
                 separator(),
-                hbox({
-                    play_classic->Render() | size(WIDTH, EQUAL, 5) | bold |
-                        center,
-                    text("ClassicFM") | bold | center,
-                }) | center,
+                visualizer,
                 separator(),
-                hbox({
-                #ifdef WITH_CAVA
-                    // separator(),
-                    create_visualizer_bars() | flex,
-                #else
-                    [&]() -> Element {
-                      // Fetch the ASCII art for testing
-                      auto art = get_track_ascii_art({});
-                      // Convert each line into an FTXUI Element
-                      std::vector<Element> art_elements;
-                      for (const auto &line : art) {
-                        art_elements.push_back(text(line) | color(Color::Blue));
-                      }
-                      return vbox(std::move(art_elements)) | center;
-                    }(),
-                #endif
-                }) | center,
-                separator(),
-                hbox({
-                    text("♪ ") | color(Color::Blue),
-                    volume_slider->Render(),
-                }),
-                //////// Volume slider with %
-                ///////////////////////////////////////
-                // hbox({
-                //     text("🔊 ") | color(Color::Blue),
-                //     volume_slider->Render() | flex,
-                //     text(std::to_string(volume) + "%") | size(WIDTH, EQUAL,
-                //     4),
-                // }) | size(HEIGHT, EQUAL, 1),
-                /////////////////////////////////////////////////////////////////
-            }) | size(WIDTH, EQUAL, 30) |
+                volume_bar,
+            }) | size(WIDTH, EQUAL, sidebar_width) |
                 border,
             vbox({
-                hbox({
-                    text("Search: ") | bold,
-                    input_search->Render(),
-                }) | border,
-                separator(),
-                text("Available Tracks:") | bold,
-                /* menu->Render() | frame | flex, */
-                hbox(
-                    {vbox({
-                         menu->Render() | frame | size(HEIGHT, EQUAL, 22) |
-                             size(WIDTH, EQUAL, 90),
-                     }),
-                     separator(),
-                     /* vbox({ */
-                     /*      menu2->Render(), */
-                     /* }), */
-                     vbox({hbox({
-                               filler(),
-                               text(" Trendings ") | bold | color(Color::White),
-                               filler(),
-                           }),
-                           separator(), trending_menu->Render() | frame}) |
-                         vscroll_indicator | yframe | flex |
-                         size(HEIGHT, EQUAL, 22)}),
-
-                // Conditionally render subtitle section based on toggle state
-                (player->are_subtitles_enabled() && !current_subtitle_text.empty()) ?
-                  vbox({
-                    hbox({
-                      text("Subtitle: ") | bold | color(Color::LightSkyBlue1),
-                      text(current_subtitle_text),
-                    }),
-                    separator(),
-                  }) : vbox({
-                        separator(),
-                      }),
+                lists,
+                lyrics,
             }) | flex,
         }),
         filler(),
-        vbox({
-            hbox({
-                progress_slider->Render() | flex,
-            }),
-            hbox({
-                filler(),
-                button_prev->Render(),
-                play_button->Render(),
-                button_next->Render(),
-                filler(),
-            }) | center,
-        }),
+        controls,
         separator(),
         hbox({text(" λ TUISIC ") | bgcolor(Color::Blue) |
                   color(Color::White),
@@ -1666,6 +1677,10 @@ int main(int argc, char *argv[]) {
                   text(">/<:Next/Prev ") | dim,
                   text("m:Mute ") | dim,
               }) | center,
+              show_render_stats ? text(frame_scheduler.summary() + " ") | dim
+                                : text(""),
+              // Last Enter-to-audio time and its slowest stage
+              text(latency::tracker().summary()) | dim,
               text(fmt::format(" {} Tracks ",
                                current_source == PlaylistSource::Search
                                    ? track_data.size()
@@ -1674,6 +1689,16 @@ int main(int argc, char *argv[]) {
     });
   });
 
+  // Ask the terminal for focus in/out reports while the UI is up
+  std::cout << kFocusReportingOn << std::flush;
   screen.Loop(renderer);
+  std::cout << kFocusReportingOff << std::flush;
+  idle::coordinator().set(idle::Unfocused, false);
+
+  // Join outstanding work while the locals it captured are still alive;
+  // requests still on the network are cut short rather than waited for
+  http::abort_all();
+  tasks::shared().shutdown();
+  saveSession({trending_tracks, home_track_data, search_query});
   return 0;
 }
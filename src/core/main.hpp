@@ -5,6 +5,9 @@
 #include "../audio/player.hpp"
 #include "../services/soundcloud/soundcloud.hpp"
 #include "../common/Track.h"
+#include "../common/lazy.hpp"
+#include "../ui/frame_scheduler.hpp"
+#include "../ui/ui_store.hpp"
 #include <curl/curl.h>
 #include <curl/urlapi.h>
 #include <ftxui/component/component.hpp> // for Renderer, Input, Menu, etc.
@@ -37,11 +40,13 @@ extern std::string current_artist;
 extern int current_track_index;
 
 extern Fetch fetch;
-extern SoundCloud soundcloud;
-extern std::shared_ptr<MusicPlayer> player;
+extern Lazy<SoundCloud> soundcloud;
+extern Lazy<MusicPlayer> player;
 
 extern PlaylistSource current_source;
 extern ftxui::ScreenInteractive screen;
+extern FrameScheduler frame_scheduler;
+extern UiStore ui_store;
 extern int selected;
 
 extern std::map<std::string, std::vector<std::string>> ascii_art;
@@ -0,0 +1,463 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <curl/curl.h>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// In-process HTTP downloader for tracks that already carry a direct media
+// URL (Forest FM .mp3 links, CDN audio files). The file is fetched as a few
+// parallel byte ranges written with pwrite() into a preallocated ".part"
+// file; a small ".part.state" sidecar remembers how far every range got so
+// an interrupted download resumes with Range requests instead of restarting.
+// A resume needs the same length, ETag and Last-Modified as before and a
+// .part file of that length; anything else starts over.
+// The payload is stored as-is, so the original codec is kept.
+class HttpDownloader {
+public:
+  struct Result {
+    bool ok = false;
+    std::string path;
+    std::string error;
+  };
+
+  explicit HttpDownloader(int max_segments = 4)
+      : max_segments(std::max(1, max_segments)) {}
+
+  // True when the URL points straight at an audio file rather than at a
+  // web page that still needs yt-dlp to be resolved
+  static bool is_direct_media_url(const std::string &url) {
+    if (url.rfind("http://", 0) != 0 && url.rfind("https://", 0) != 0) {
+      return false;
+    }
+    return !extension_from_url(url).empty();
+  }
+
+  // Downloads url into directory/basename.<ext>, the extension taken from
+  // the URL or the response content type
+  Result download(const std::string &url, const std::string &directory,
+                  const std::string &basename) {
+    Result result;
+#ifdef _WIN32
+    result.error = "Native downloads are not supported on this platform";
+    return result;
+#else
+    Probe info = probe(url);
+    if (!info.ok) {
+      result.error = "Failed to reach " + url;
+      return result;
+    }
+
+    std::string ext = extension_from_url(info.effective_url);
+    if (ext.empty()) ext = extension_from_url(url);
+    if (ext.empty()) ext = extension_from_content_type(info.content_type);
+    if (ext.empty()) ext = "bin";
+
+    result.path = directory + "/" + basename + "." + ext;
+    const std::string part_path = result.path + ".part";
+    const std::string state_path = part_path + ".state";
+
+    int fd = ::open(part_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+      result.error = "Cannot open " + part_path + ": " + std::strerror(errno);
+      return result;
+    }
+
+    std::vector<Segment> segments;
+    bool resumed = false;
+    if (info.length > 0 && info.ranges) {
+      // Ranges marked done are only there if the .part file still is
+      struct stat st {};
+      resumed = ::fstat(fd, &st) == 0 && st.st_size == info.length &&
+                load_state(state_path, info, segments);
+      if (!resumed) {
+        segments = plan_segments(info.length);
+      }
+    } else {
+      // No length or no range support: a single stream from the start
+      segments.push_back(Segment{0, info.length > 0 ? info.length - 1 : -1, 0});
+    }
+
+    if (!resumed && ::ftruncate(fd, 0) != 0) {
+      ::close(fd);
+      result.error = "Cannot truncate " + part_path;
+      return result;
+    }
+    if (info.length > 0 && info.ranges) {
+      preallocate(fd, info.length);
+    }
+
+    Transfer transfer{this, fd, state_path, info.length, info.etag,
+                      info.last_modified, &segments, {}, {false}};
+    std::vector<std::thread> workers;
+    workers.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+      if (segments[i].complete()) continue;
+      workers.emplace_back([&transfer, &url, i] {
+        transfer.owner->fetch_segment(url, transfer, i);
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+
+    bool complete = !transfer.failed;
+    for (const auto &segment : segments) {
+      complete = complete && segment.complete();
+    }
+
+    ::fsync(fd);
+    ::close(fd);
+
+    if (!complete) {
+      // Keep the .part file and state so the next attempt resumes
+      if (info.length > 0 && info.ranges) {
+        save_state(transfer);
+      }
+      result.error = "Download interrupted: " + basename;
+      return result;
+    }
+
+    if (std::rename(part_path.c_str(), result.path.c_str()) != 0) {
+      result.error = "Cannot move " + part_path + " into place";
+      return result;
+    }
+    std::remove(state_path.c_str());
+    result.ok = true;
+    return result;
+#endif
+  }
+
+private:
+  static constexpr curl_off_t MIN_SEGMENT_SIZE = 512 * 1024;
+  static constexpr curl_off_t CHECKPOINT_BYTES = 256 * 1024;
+
+  int max_segments;
+
+  struct Probe {
+    bool ok = false;
+    curl_off_t length = -1;
+    bool ranges = false;
+    std::string content_type;
+    std::string effective_url;
+    std::string etag;          // as sent, quotes and W/ included
+    std::string last_modified;
+  };
+
+  struct Segment {
+    curl_off_t start;
+    curl_off_t end; // inclusive, -1 when the length is unknown
+    curl_off_t done;
+
+    bool complete() const { return end >= 0 && start + done > end; }
+  };
+
+  struct Transfer {
+    HttpDownloader *owner;
+    int fd;
+    std::string state_path;
+    curl_off_t length;
+    std::string etag;
+    std::string last_modified;
+    std::vector<Segment> *segments;
+    std::mutex state_mutex;
+    std::atomic_bool failed;
+  };
+
+  struct SegmentContext {
+    Transfer *transfer;
+    size_t index;
+    CURL *curl;
+    bool checked_status = false;
+    curl_off_t since_checkpoint = 0;
+  };
+
+  static std::string lower(std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return value;
+  }
+
+  static std::string extension_from_url(const std::string &url) {
+    std::string path = url.substr(0, url.find_first_of("?#"));
+    size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+      return "";
+    }
+    std::string ext = lower(path.substr(dot + 1));
+    static const char *known[] = {"mp3", "m4a", "aac", "mp4", "ogg",
+                                  "oga", "opus", "flac", "wav", "webm"};
+    for (const char *candidate : known) {
+      if (ext == candidate) return ext;
+    }
+    return "";
+  }
+
+  static std::string extension_from_content_type(const std::string &content_type) {
+    std::string type = lower(content_type.substr(0, content_type.find(';')));
+    if (type == "audio/mpeg" || type == "audio/mp3") return "mp3";
+    if (type == "audio/mp4" || type == "audio/x-m4a") return "m4a";
+    if (type == "audio/aac") return "aac";
+    if (type == "audio/ogg") return "ogg";
+    if (type == "audio/opus") return "opus";
+    if (type == "audio/flac" || type == "audio/x-flac") return "flac";
+    if (type == "audio/wav" || type == "audio/x-wav") return "wav";
+    if (type == "audio/webm") return "webm";
+    return "";
+  }
+
+  static size_t discard_callback(char *, size_t size, size_t nmemb, void *) {
+    return size * nmemb;
+  }
+
+  static size_t header_callback(char *buffer, size_t size, size_t nitems,
+                                void *userdata) {
+    auto *info = static_cast<Probe *>(userdata);
+    std::string raw(buffer, size * nitems);
+    std::string line = lower(raw);
+    if (line.rfind("http/", 0) == 0) {
+      *info = Probe{}; // a redirect's headers don't describe the file
+    } else if (line.rfind("accept-ranges:", 0) == 0 &&
+               line.find("bytes") != std::string::npos) {
+      info->ranges = true;
+    } else if (line.rfind("etag:", 0) == 0) {
+      info->etag = header_value(raw);
+    } else if (line.rfind("last-modified:", 0) == 0) {
+      info->last_modified = header_value(raw);
+    }
+    return size * nitems;
+  }
+
+  // Text after the colon, without surrounding whitespace or the CRLF
+  static std::string header_value(const std::string &line) {
+    size_t begin = line.find(':') + 1;
+    size_t end = line.find_last_not_of(" \t\r\n");
+    begin = line.find_first_not_of(" \t", begin);
+    if (begin == std::string::npos || end == std::string::npos || end < begin) {
+      return "";
+    }
+    return line.substr(begin, end - begin + 1);
+  }
+
+  static void apply_common_options(CURL *curl, const std::string &url) {
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, "tuisic/1.0");
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 15L);
+    // Give up on a range that stalls below 1 KiB/s for 30 seconds
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1024L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 30L);
+  }
+
+  Probe probe(const std::string &url) {
+    Probe info;
+    CURL *curl = curl_easy_init();
+    if (!curl) return info;
+
+    apply_common_options(curl, url);
+    curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discard_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &info);
+
+    if (curl_easy_perform(curl) == CURLE_OK) {
+      info.ok = true;
+      curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &info.length);
+      char *type = nullptr;
+      if (curl_easy_getinfo(curl, CURLINFO_CONTENT_TYPE, &type) == CURLE_OK && type) {
+        info.content_type = type;
+      }
+      char *effective = nullptr;
+      if (curl_easy_getinfo(curl, CURLINFO_EFFECTIVE_URL, &effective) == CURLE_OK &&
+          effective) {
+        info.effective_url = effective;
+      }
+    }
+    curl_easy_cleanup(curl);
+
+    if (info.effective_url.empty()) info.effective_url = url;
+    return info;
+  }
+
+  std::vector<Segment> plan_segments(curl_off_t length) const {
+    curl_off_t count = std::min<curl_off_t>(max_segments,
+                                            std::max<curl_off_t>(1, length / MIN_SEGMENT_SIZE));
+    curl_off_t chunk = length / count;
+    std::vector<Segment> segments;
+    segments.reserve(count);
+    for (curl_off_t i = 0; i < count; ++i) {
+      curl_off_t start = i * chunk;
+      curl_off_t end = (i == count - 1) ? length - 1 : start + chunk - 1;
+      segments.push_back(Segment{start, end, 0});
+    }
+    return segments;
+  }
+
+#ifndef _WIN32
+  static void preallocate(int fd, curl_off_t length) {
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && st.st_size == length) {
+      return; // Resuming into an already sized file
+    }
+#if defined(PLATFORM_LINUX) || defined(__linux__)
+    if (::fallocate(fd, 0, 0, length) == 0) {
+      return;
+    }
+#endif
+    // Filesystems without fallocate support still get the right size
+    if (::ftruncate(fd, length) != 0) {
+      // pwrite() extends the file as needed, so this is not fatal
+    }
+  }
+#endif
+
+  // State file: "<length> <segments>", the ETag and the Last-Modified on
+  // a line each (empty when the server sent none), then one
+  // "<start> <end> <done>" line per segment
+  static bool load_state(const std::string &path, const Probe &info,
+                         std::vector<Segment> &segments) {
+    std::ifstream in(path);
+    if (!in.good()) return false;
+
+    curl_off_t saved_length = 0;
+    size_t count = 0;
+    if (!(in >> saved_length >> count) || saved_length != info.length ||
+        count == 0) {
+      return false;
+    }
+    std::string etag, last_modified;
+    in.ignore(1); // the newline after the count
+    if (!std::getline(in, etag) || !std::getline(in, last_modified) ||
+        etag != info.etag || last_modified != info.last_modified) {
+      return false; // changed on the server, or a state file from before
+    }
+    std::vector<Segment> loaded;
+    for (size_t i = 0; i < count; ++i) {
+      Segment segment{0, 0, 0};
+      if (!(in >> segment.start >> segment.end >> segment.done)) return false;
+      loaded.push_back(segment);
+    }
+    segments = std::move(loaded);
+    return true;
+  }
+
+  static void save_state(Transfer &transfer) {
+    std::lock_guard<std::mutex> lock(transfer.state_mutex);
+    std::string tmp_path = transfer.state_path + ".tmp";
+    {
+      std::ofstream out(tmp_path, std::ios::trunc);
+      out << transfer.length << " " << transfer.segments->size() << "\n";
+      out << transfer.etag << "\n" << transfer.last_modified << "\n";
+      for (const auto &segment : *transfer.segments) {
+        out << segment.start << " " << segment.end << " " << segment.done << "\n";
+      }
+    }
+    std::rename(tmp_path.c_str(), transfer.state_path.c_str());
+  }
+
+  static size_t segment_write_callback(char *data, size_t size, size_t nmemb,
+                                       void *userdata) {
+#ifdef _WIN32
+    return 0;
+#else
+    auto *ctx = static_cast<SegmentContext *>(userdata);
+    Transfer &transfer = *ctx->transfer;
+    Segment &segment = (*transfer.segments)[ctx->index];
+    const size_t total = size * nmemb;
+
+    if (transfer.failed) {
+      return 0; // Another range failed, abort this one too
+    }
+
+    if (!ctx->checked_status) {
+      long status = 0;
+      curl_easy_getinfo(ctx->curl, CURLINFO_RESPONSE_CODE, &status);
+      // A 200 answer to a ranged request would write the whole body at
+      // the wrong offset
+      if (segment.start + segment.done > 0 && status != 206) {
+        return 0;
+      }
+      ctx->checked_status = true;
+    }
+
+    size_t written = 0;
+    while (written < total) {
+      ssize_t n = ::pwrite(transfer.fd, data + written, total - written,
+                           segment.start + segment.done);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        return 0;
+      }
+      written += static_cast<size_t>(n);
+      std::lock_guard<std::mutex> lock(transfer.state_mutex);
+      segment.done += n;
+    }
+
+    ctx->since_checkpoint += total;
+    if (ctx->since_checkpoint >= CHECKPOINT_BYTES && transfer.length > 0) {
+      ctx->since_checkpoint = 0;
+      save_state(transfer);
+    }
+    return total;
+#endif
+  }
+
+  void fetch_segment(const std::string &url, Transfer &transfer, size_t index) {
+    Segment &segment = (*transfer.segments)[index];
+    CURL *curl = curl_easy_init();
+    if (!curl) {
+      transfer.failed = true;
+      return;
+    }
+
+    SegmentContext ctx{&transfer, index, curl};
+    apply_common_options(curl, url);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, segment_write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &ctx);
+
+    std::string range;
+    struct curl_slist *headers = nullptr;
+    if (segment.end >= 0) {
+      range = std::to_string(segment.start + segment.done) + "-" +
+              std::to_string(segment.end);
+      curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+      // Should the file change after the probe, the server answers 200
+      // and the status check above refuses it. If-Range takes only a
+      // strong ETag; a weak one would always get the 200.
+      bool strong = !transfer.etag.empty() && transfer.etag.rfind("W/", 0) != 0;
+      const std::string &validator = strong ? transfer.etag : transfer.last_modified;
+      if (!validator.empty()) {
+        headers = curl_slist_append(headers, ("If-Range: " + validator).c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+      }
+    }
+
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+      transfer.failed = true;
+    } else if (segment.end < 0) {
+      // Unknown length: the stream ending cleanly is what completes it
+      segment.end = segment.start + segment.done - 1;
+    }
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(headers);
+  }
+};
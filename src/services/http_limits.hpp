@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <curl/curl.h>
+
+// Limits for the page and API requests the service clients make. Without
+// them a stalled connection blocks its task forever, and with it 'q'
+// (tasks::shared().shutdown() joins in-flight jobs) and the control
+// server's stop(). Downloads set their own, longer ones.
+namespace http {
+
+constexpr long kConnectTimeoutSeconds = 10;
+constexpr long kRequestTimeoutSeconds = 20;
+
+inline std::atomic<bool> &aborting() {
+  static std::atomic<bool> flag{false};
+  return flag;
+}
+
+// On the way out: every request in flight, and any started later, fails
+// within about a second instead of running to its timeout
+inline void abort_all() { aborting().store(true); }
+
+inline int abort_check(void *, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+  return aborting().load(std::memory_order_relaxed) ? 1 : 0;
+}
+
+inline void apply_limits(CURL *curl) {
+  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, kConnectTimeoutSeconds);
+  curl_easy_setopt(curl, CURLOPT_TIMEOUT, kRequestTimeoutSeconds);
+  // Resolver timeouts otherwise use SIGALRM, which isn't thread-safe
+  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, abort_check);
+  curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+}
+
+} // namespace http
@@ -1,4 +1,5 @@
 #include "../../common/Track.h"
+#include "../http_limits.hpp"
 #include <curl/curl.h>
 #include <iostream>
 #include <regex>
@@ -24,6 +25,7 @@ public:
       curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
       curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
       curl_easy_setopt(curl, CURLOPT_WRITEDATA, &content);
+      http::apply_limits(curl);
       res = curl_easy_perform(curl);
       curl_easy_cleanup(curl);
     }
@@ -5,6 +5,7 @@
 #include <regex>
 #include <memory>
 #include "../../common/Track.h"
+#include "../http_limits.hpp"
 #include <mpv/client.h>
 
 // Performance tuning constants
@@ -40,6 +41,7 @@ class Lastfm {
                     curl_easy_setopt(curl_handle.get(), CURLOPT_USERAGENT, "Mozilla/5.0");
                     curl_easy_setopt(curl_handle.get(), CURLOPT_FOLLOWLOCATION, 1L);
                     curl_easy_setopt(curl_handle.get(), CURLOPT_HTTPHEADER, headers);
+                    http::apply_limits(curl_handle.get());
                 }
             }
         }
@@ -77,7 +79,7 @@ class Lastfm {
                 track.url = match[1];
                 track.name = match[2];
                 track.artist = match[3];
-                track.id = track.name;
+                track.id = track.url; // the page path is unique, the title isn't
                 track.source = "lastfm";
                 tracks.push_back(std::move(track));
             }
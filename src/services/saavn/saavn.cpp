@@ -1,4 +1,5 @@
 #include "../../common/Track.h"
+#include "../http_limits.hpp"
 #include <curl/curl.h>
 #include <iostream>
 #include <mpv/client.h>
@@ -33,6 +34,7 @@ class Saavn {
                     curl_easy_setopt(curl_handle.get(), CURLOPT_USERAGENT, "Mozilla/5.0");
                     curl_easy_setopt(curl_handle.get(), CURLOPT_FOLLOWLOCATION, 1L);
                     curl_easy_setopt(curl_handle.get(), CURLOPT_HTTPHEADER, headers);
+                    http::apply_limits(curl_handle.get());
                 }
             }
         }
@@ -7,6 +7,7 @@
 #include <regex>
 #include <rapidjson/document.h>
 #include "../../common/Track.h"
+#include "../http_limits.hpp"
 #include "../../common/notification.hpp"
 
 class SoundCloud{
@@ -48,7 +49,7 @@ class SoundCloud{
                 if (lastSlash != std::string::npos) {
                     track.artist = path.substr(1, lastSlash - 1);  // Remove leading /
                     track.name = path.substr(lastSlash + 1);
-                    track.id = track.name;
+                    track.id = path; // "/artist/slug"; the slug alone repeats across artists
                     track.name = std::regex_replace(track.name, std::regex("-"), " "); // Replace - with spaces
                     track.source = "soundcloud";
                 }
@@ -90,6 +91,7 @@ class SoundCloud{
             curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
             curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
             curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+            http::apply_limits(curl);
 
             CURLcode res = curl_easy_perform(curl);
             if (res != CURLE_OK) {
@@ -213,6 +215,7 @@ class SoundCloud{
                 curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
                 curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
                 curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+                http::apply_limits(curl);
 
                 CURLcode res = curl_easy_perform(curl);
 
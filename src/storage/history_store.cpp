@@ -0,0 +1,371 @@
+#include "../common/Track.h"
+#include "../common/paths.hpp"
+#include "../common/notification.hpp"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <fcntl.h>
+#include <list>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+// Every play ever made, as one line per play in history.log,
+//
+//   {"at":<unix seconds>,"track":[name,artist,url,id,source]}
+//
+// and indexed in memory: play count and last play per track, totals per
+// artist, plays per calendar month, and the order in which distinct
+// tracks were last heard. The newest `capacity` plays are also kept as
+// a ring. The log is read the first time a query needs it, not at
+// start-up; plays before that are only appended. After loading, every
+// query below costs the size of its answer (plus one partial sort for
+// the top-N ones), not the length of the history.
+class HistoryStore {
+public:
+  struct TrackStats {
+    Track track;
+    uint32_t plays = 0;
+    int64_t last_played = 0; // 0 for plays imported without a time
+  };
+
+  struct ArtistStats {
+    std::string artist;
+    uint32_t plays = 0;
+    uint32_t tracks = 0; // distinct
+    int64_t last_played = 0;
+  };
+
+  explicit HistoryStore(size_t capacity) : capacity(std::max<size_t>(1, capacity)) {}
+
+  ~HistoryStore() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  HistoryStore(const HistoryStore &) = delete;
+  HistoryStore &operator=(const HistoryStore &) = delete;
+
+  size_t ring_capacity() const { return capacity; }
+
+  // Set by TrackJournal when another instance holds its lock; that one
+  // owns history.log too. Plays still count here, until exit.
+  void set_read_only() { read_only = true; }
+
+  static int64_t now() { return static_cast<int64_t>(std::time(nullptr)); }
+
+  // Seeds the log from the history tracks.json kept before it existed.
+  // Runs once; those plays have no time and don't count for any month.
+  void import_legacy(TrackList &recent) {
+    if (::access(log_path().c_str(), F_OK) == 0) {
+      return;
+    }
+    size_t count = recent.size();
+    for (size_t i = 0; i < count; ++i) {
+      const Track &track = recent.at(i);
+      if (!track.url.empty()) {
+        record(track, 0);
+      }
+    }
+  }
+
+  void record(const Track &track, int64_t at = now()) {
+    append(track, at);
+    if (loaded) {
+      add(track, at);
+    }
+  }
+
+  // Latest plays, newest first, repeats included; at most ring_capacity()
+  std::vector<Track> recent(size_t count) {
+    load();
+    std::vector<Track> result;
+    for (auto it = ring.rbegin(); it != ring.rend() && result.size() < count; ++it) {
+      result.push_back(entries[it->entry].track);
+    }
+    return result;
+  }
+
+  // Distinct tracks by their last play, newest first
+  std::vector<Track> recent_unique(size_t count) {
+    load();
+    std::vector<Track> result;
+    result.reserve(std::min(count, recency.size()));
+    for (auto it = recency.begin(); it != recency.end() && result.size() < count; ++it) {
+      result.push_back(entries[*it].track);
+    }
+    return result;
+  }
+
+  // Most played of all time; ties go to the more recent
+  std::vector<TrackStats> top_tracks(size_t count) {
+    load();
+    std::vector<uint32_t> ids(entries.size());
+    for (uint32_t i = 0; i < ids.size(); ++i) {
+      ids[i] = i;
+    }
+    count = std::min(count, ids.size());
+    std::partial_sort(ids.begin(), ids.begin() + count, ids.end(),
+                      [this](uint32_t a, uint32_t b) {
+                        return more_played(entries[a].plays, entries[a].last_played,
+                                           entries[b].plays, entries[b].last_played);
+                      });
+    std::vector<TrackStats> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      result.push_back(entries[ids[i]]);
+    }
+    return result;
+  }
+
+  // Most played in the calendar month (local time) holding `at`; `plays`
+  // counts that month only
+  std::vector<TrackStats> top_tracks_in_month(size_t count, int64_t at = now()) {
+    load();
+    auto month = monthly.find(month_of(at));
+    if (month == monthly.end()) {
+      return {};
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> counts(month->second.begin(),
+                                                      month->second.end());
+    count = std::min(count, counts.size());
+    std::partial_sort(counts.begin(), counts.begin() + count, counts.end(),
+                      [this](const auto &a, const auto &b) {
+                        return more_played(a.second, entries[a.first].last_played,
+                                           b.second, entries[b.first].last_played);
+                      });
+    std::vector<TrackStats> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      TrackStats stats = entries[counts[i].first];
+      stats.plays = counts[i].second;
+      result.push_back(std::move(stats));
+    }
+    return result;
+  }
+
+  std::vector<ArtistStats> top_artists(size_t count) {
+    load();
+    std::vector<const ArtistStats *> all;
+    all.reserve(artists.size());
+    for (const auto &artist : artists) {
+      all.push_back(&artist.second);
+    }
+    count = std::min(count, all.size());
+    std::partial_sort(all.begin(), all.begin() + count, all.end(),
+                      [](const ArtistStats *a, const ArtistStats *b) {
+                        return more_played(a->plays, a->last_played, b->plays,
+                                           b->last_played);
+                      });
+    std::vector<ArtistStats> result;
+    result.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+      result.push_back(*all[i]);
+    }
+    return result;
+  }
+
+  // nullptr if never played
+  const TrackStats *stats(const Track &track) {
+    load();
+    auto it = by_key.find(track.key());
+    return it == by_key.end() ? nullptr : &entries[it->second];
+  }
+
+  const ArtistStats *artist(const std::string &name) {
+    load();
+    auto it = artists.find(name);
+    return it == artists.end() ? nullptr : &it->second;
+  }
+
+private:
+  struct Entry : TrackStats {
+    std::list<uint32_t>::iterator recency_slot;
+  };
+
+  struct Play {
+    uint32_t entry;
+    int64_t at;
+  };
+
+  size_t capacity;
+  int fd = -1;
+  bool read_only = false;
+  bool loaded = false;
+  std::vector<Entry> entries;
+  std::unordered_map<std::string, uint32_t> by_key;
+  std::unordered_map<std::string, ArtistStats> artists;
+  std::unordered_map<int, std::unordered_map<uint32_t, uint32_t>> monthly;
+  std::list<uint32_t> recency; // distinct tracks, last played first
+  std::deque<Play> ring;
+
+  static std::string log_path() {
+    return paths::get_data_dir() + "/history.log";
+  }
+
+  static bool more_played(uint32_t plays_a, int64_t last_a, uint32_t plays_b,
+                          int64_t last_b) {
+    return plays_a != plays_b ? plays_a > plays_b : last_a > last_b;
+  }
+
+  static int month_of(int64_t at) {
+    std::time_t time = static_cast<std::time_t>(at);
+    std::tm local{};
+    localtime_r(&time, &local);
+    return local.tm_year * 12 + local.tm_mon;
+  }
+
+  void add(const Track &track, int64_t at) {
+    auto [slot, inserted] = by_key.try_emplace(track.key(),
+                                                static_cast<uint32_t>(entries.size()));
+    uint32_t id = slot->second;
+    if (inserted) {
+      entries.emplace_back();
+      entries.back().track = track;
+      recency.push_front(id);
+      entries.back().recency_slot = recency.begin();
+    } else {
+      recency.splice(recency.begin(), recency, entries[id].recency_slot);
+    }
+
+    Entry &entry = entries[id];
+    entry.plays++;
+    entry.last_played = std::max(entry.last_played, at);
+
+    // Keyed by the artist as first seen, so the totals stay in one place
+    ArtistStats &artist = artists[entry.track.artist];
+    if (artist.plays == 0) {
+      artist.artist = entry.track.artist;
+    }
+    artist.plays++;
+    artist.tracks += inserted ? 1 : 0;
+    artist.last_played = std::max(artist.last_played, at);
+
+    if (at > 0) {
+      monthly[month_of(at)][id]++;
+    }
+    ring.push_back({id, at});
+    if (ring.size() > capacity) {
+      ring.pop_front();
+    }
+  }
+
+  // Lines that don't parse (a write cut short by a crash) are skipped
+  void load() {
+    if (loaded) {
+      return;
+    }
+    loaded = true;
+    FILE *file = fopen(log_path().c_str(), "rb");
+    if (!file) {
+      return;
+    }
+    char *line = nullptr;
+    size_t line_capacity = 0;
+    while (::getline(&line, &line_capacity, file) > 0) {
+      rapidjson::Document doc;
+      if (doc.Parse(line).HasParseError() || !doc.IsObject() ||
+          !doc.HasMember("at") || !doc["at"].IsInt64() ||
+          !doc.HasMember("track") || !doc["track"].IsArray() ||
+          doc["track"].Size() != 5) {
+        continue;
+      }
+      Track track;
+      std::string *fields[] = {&track.name, &track.artist, &track.url, &track.id,
+                               &track.source};
+      bool valid = true;
+      for (rapidjson::SizeType i = 0; i < 5 && valid; ++i) {
+        valid = doc["track"][i].IsString();
+        if (valid) {
+          *fields[i] = doc["track"][i].GetString();
+        }
+      }
+      if (valid) {
+        add(track, doc["at"].GetInt64());
+      }
+    }
+    std::free(line);
+    fclose(file);
+  }
+
+  // A crash mid-write leaves a last line without its '\n'; the next
+  // append would be glued onto it and both lost. Cut back to the last
+  // complete line, as TrackJournal::recover does.
+  void trim_torn_tail() {
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+      return;
+    }
+    off_t end = info.st_size;
+    char buffer[4096];
+    while (end > 0) {
+      off_t start = std::max<off_t>(0, end - static_cast<off_t>(sizeof(buffer)));
+      ssize_t n = ::pread(fd, buffer, static_cast<size_t>(end - start), start);
+      if (n != end - start) {
+        return; // leave it; load() skips what it can't parse
+      }
+      for (ssize_t i = n; i-- > 0;) {
+        if (buffer[i] == '\n') {
+          off_t good_end = start + i + 1;
+          if (good_end != info.st_size && ::ftruncate(fd, good_end) != 0) {
+            notifications::send("Failed to trim play history");
+          }
+          return;
+        }
+      }
+      end = start;
+    }
+    if (::ftruncate(fd, 0) != 0) { // not one complete line
+      notifications::send("Failed to trim play history");
+    }
+  }
+
+  // Not synced: losing the last plays to a power cut costs statistics,
+  // not data anyone curated
+  void append(const Track &track, int64_t at) {
+    if (read_only) {
+      return;
+    }
+    if (fd < 0) {
+      paths::ensure_directory_exists(paths::get_data_dir());
+      fd = ::open(log_path().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+      if (fd < 0) {
+        notifications::send(std::string("Play history unavailable: ") +
+                            std::strerror(errno));
+        return;
+      }
+      trim_torn_tail();
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("at");
+    writer.Int64(at);
+    writer.Key("track");
+    writer.StartArray();
+    for (const std::string *field : {&track.name, &track.artist, &track.url,
+                                     &track.id, &track.source}) {
+      writer.String(field->c_str(), static_cast<rapidjson::SizeType>(field->size()));
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    std::string line(buffer.GetString(), buffer.GetSize());
+    line.push_back('\n');
+    if (::write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+      notifications::send("Failed to append to play history");
+    }
+  }
+};
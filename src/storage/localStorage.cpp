@@ -4,26 +4,89 @@
 #include "rapidjson/filewritestream.h"
 #include "rapidjson/filereadstream.h"
 #include "rapidjson/writer.h"
+#include <cstdint>
 #include <cstdio>
 #include <iostream>
 #include <ostream>
+#include <string>
 #include <vector>
 #include <filesystem>
+#include <algorithm>
+#include <fcntl.h>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
 #include "../common/notification.hpp"
 
-void saveData(const std::vector<Track> &recentlyPlayed,
-              const std::vector<Track> &favorites_tracks) {
+namespace {
+
+void add_track_fields(rapidjson::Value& trackObj, const Track& track,
+                      rapidjson::Document::AllocatorType& allocator) {
+    trackObj.AddMember("name", rapidjson::StringRef(track.name.c_str()), allocator);
+    trackObj.AddMember("artist", rapidjson::StringRef(track.artist.c_str()), allocator);
+    trackObj.AddMember("url", rapidjson::StringRef(track.url.c_str()), allocator);
+    trackObj.AddMember("id", rapidjson::StringRef(track.id.c_str()), allocator);
+    trackObj.AddMember("source", rapidjson::StringRef(track.source.c_str()), allocator);
+}
+
+bool read_track_fields(const rapidjson::Value& trackJson, Track& track) {
+    if (!trackJson.IsObject()) {
+        return false;
+    }
+    for (const char* key : {"name", "artist", "url"}) {
+        if (!trackJson.HasMember(key) || !trackJson[key].IsString()) {
+            return false;
+        }
+    }
+    track.name = trackJson["name"].GetString();
+    track.artist = trackJson["artist"].GetString();
+    track.url = trackJson["url"].GetString();
+    // Older files only have the three fields above
+    if (trackJson.HasMember("id") && trackJson["id"].IsString()) {
+        track.id = trackJson["id"].GetString();
+    }
+    if (trackJson.HasMember("source") && trackJson["source"].IsString()) {
+        track.source = trackJson["source"].GetString();
+    }
+    return true;
+}
+
+bool sync_directory(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+} // namespace
+
+inline std::string tracks_file_path() {
+    return paths::get_data_dir() + "/tracks.json";
+}
+
+// `journal_seq` is the last journal record folded into this snapshot.
+// The file is replaced by rename, so a crash leaves the old or the new
+// snapshot, never half of one. False unless the new one is durably in
+// place (file and directory synced).
+bool saveData(const std::vector<Track> &recentlyPlayed,
+              const std::vector<Track> &favorites_tracks,
+              uint64_t journal_seq = 0) {
     rapidjson::Document data;
     data.SetObject();
     rapidjson::Document::AllocatorType& allocator = data.GetAllocator();
+    // First member, so TrackFile reads it without scanning the lists
+    data.AddMember("journalSeq", journal_seq, allocator);
 
     // Create JSON array for recently played tracks
     rapidjson::Value recentlyPlayedArray(rapidjson::kArrayType);
     for (const auto& track : recentlyPlayed) {
         rapidjson::Value trackObj(rapidjson::kObjectType);
-        trackObj.AddMember("name", rapidjson::StringRef(track.name.c_str()), allocator);
-        trackObj.AddMember("artist", rapidjson::StringRef(track.artist.c_str()), allocator);
-        trackObj.AddMember("url", rapidjson::StringRef(track.url.c_str()), allocator);
+        add_track_fields(trackObj, track, allocator);
         recentlyPlayedArray.PushBack(trackObj, allocator);
     }
     data.AddMember("recentlyPlayed", recentlyPlayedArray, allocator);
@@ -32,9 +95,7 @@ void saveData(const std::vector<Track> &recentlyPlayed,
     rapidjson::Value favoritesArray(rapidjson::kArrayType);
     for (const auto& track : favorites_tracks) {
         rapidjson::Value trackObj(rapidjson::kObjectType);
-        trackObj.AddMember("name", rapidjson::StringRef(track.name.c_str()), allocator);
-        trackObj.AddMember("artist", rapidjson::StringRef(track.artist.c_str()), allocator);
-        trackObj.AddMember("url", rapidjson::StringRef(track.url.c_str()), allocator);
+        add_track_fields(trackObj, track, allocator);
         favoritesArray.PushBack(trackObj, allocator);
     }
     data.AddMember("favorites", favoritesArray, allocator);
@@ -42,12 +103,13 @@ void saveData(const std::vector<Track> &recentlyPlayed,
     // Write to file
     std::string data_dir = paths::get_data_dir();
     paths::ensure_directory_exists(data_dir);
-    std::string tracks_file = data_dir + "/tracks.json";
-    FILE* outFile = fopen(tracks_file.c_str(), "wb");
+    std::string tracks_file = tracks_file_path();
+    std::string temp_file = tracks_file + ".tmp";
+    FILE* outFile = fopen(temp_file.c_str(), "wb");
     if (!outFile) {
         // std::cerr << "Failed to open file for writing" << std::endl;
         notifications::send("Failed to open file for writing");
-        return;
+        return false;
     }
 
     char writeBuffer[65536];
@@ -55,58 +117,361 @@ void saveData(const std::vector<Track> &recentlyPlayed,
     rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
     data.Accept(writer);
 
-    fclose(outFile);
+    // Data on disk before the rename makes it visible
+    bool written = fflush(outFile) == 0 && fsync(fileno(outFile)) == 0;
+    written = fclose(outFile) == 0 && written;
+    if (!written || std::rename(temp_file.c_str(), tracks_file.c_str()) != 0) {
+        std::remove(temp_file.c_str());
+        notifications::send("Failed to save tracks");
+        return false;
+    }
+    // The rename itself is only durable once the directory is; until then
+    // a crash can still bring back the old snapshot, so the caller must
+    // not drop the journal before this succeeds
+    if (!sync_directory(data_dir)) {
+        notifications::send("Failed to sync data directory");
+        return false;
+    }
+    return true;
 }
 
 
-bool loadData(std::vector<Track> &recentlyPlayed,
-              std::vector<Track> &favorites_tracks) {
-    std::string data_dir = paths::get_data_dir();
-    std::string tracks_file = data_dir + "/tracks.json";
-    FILE* inFile = fopen(tracks_file.c_str(), "rb");
-    if (!inFile) {
-        // std::cerr << "Failed to open tracks file" << std::endl;
-        notifications::send("Failed to open tracks file");
-        return false;
+// Read-only map of tracks.json. Opening it costs the same for ten tracks
+// or a hundred thousand: nothing is parsed until a list asks for its
+// records, and then only their byte ranges are found. Each Track is
+// parsed from its range the first time it is read.
+class TrackFile {
+public:
+    struct Span {
+        size_t offset;
+        size_t length;
+    };
+
+    // nullptr when there is no snapshot yet
+    static std::shared_ptr<TrackFile> open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat info;
+        void* mapped = MAP_FAILED;
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                            MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd); // the mapping keeps the file (even once renamed over)
+        if (mapped == MAP_FAILED) {
+            return nullptr;
+        }
+        return std::shared_ptr<TrackFile>(
+            new TrackFile(static_cast<const char*>(mapped), static_cast<size_t>(info.st_size)));
     }
 
-    char readBuffer[65536];
-    rapidjson::FileReadStream is(inFile, readBuffer, sizeof(readBuffer));
-    rapidjson::Document doc;
-    doc.ParseStream(is);
-    fclose(inFile);
+    ~TrackFile() { ::munmap(const_cast<char*>(data), size); }
 
-    if (doc.HasParseError()) {
-        // std::cerr << "JSON parse error" << std::endl;
-        notifications::send("JSON parse error");
-        return false;
+    TrackFile(const TrackFile&) = delete;
+    TrackFile& operator=(const TrackFile&) = delete;
+
+    // saveData writes journalSeq first, so it is found without a scan
+    uint64_t journal_seq() const {
+        static constexpr char kKey[] = "{\"journalSeq\":";
+        const size_t key_length = sizeof(kKey) - 1;
+        std::string head(data, std::min(size, key_length + 24));
+        if (head.compare(0, key_length, kKey) != 0) {
+            return 0; // written before the journal existed
+        }
+        return std::strtoull(head.c_str() + key_length, nullptr, 10);
+    }
+
+    // Ranges of the objects in the top-level array `key`. The first call
+    // finds every top-level array in one pass over the bytes.
+    const std::vector<Span>& records(const std::string& key) {
+        if (!indexed) {
+            index();
+        }
+        static const std::vector<Span> none;
+        auto it = arrays.find(key);
+        return it == arrays.end() ? none : it->second;
+    }
+
+    bool parse(const Span& span, Track& track) const {
+        rapidjson::Document doc;
+        doc.Parse(data + span.offset, span.length);
+        return !doc.HasParseError() && read_track_fields(doc, track);
+    }
+
+private:
+    const char* data;
+    size_t size;
+    bool indexed = false;
+    std::unordered_map<std::string, std::vector<Span>> arrays;
+
+    TrackFile(const char* mapped, size_t length) : data(mapped), size(length) {}
+
+    // Tracks only strings and nesting; values are left for parse()
+    void index() {
+        indexed = true;
+        int depth = 0;
+        bool in_string = false;
+        bool escaped = false;
+        size_t string_start = 0;
+        std::string last_key;
+        std::vector<Span>* current = nullptr;
+        size_t record_start = 0;
+
+        for (size_t i = 0; i < size; ++i) {
+            char c = data[i];
+            if (in_string) {
+                if (escaped) {
+                    escaped = false;
+                } else if (c == '\\') {
+                    escaped = true;
+                } else if (c == '"') {
+                    in_string = false;
+                    if (depth == 1) {
+                        last_key.assign(data + string_start, i - string_start);
+                    }
+                }
+                continue;
+            }
+            switch (c) {
+            case '"':
+                in_string = true;
+                string_start = i + 1;
+                break;
+            case '[':
+                if (depth == 1) {
+                    current = &arrays[last_key];
+                }
+                depth++;
+                break;
+            case '{':
+                if (depth == 2 && current) {
+                    record_start = i;
+                }
+                depth++;
+                break;
+            case '}':
+                depth--;
+                if (depth == 2 && current) {
+                    current->push_back({record_start, i + 1 - record_start});
+                }
+                break;
+            case ']':
+                depth--;
+                if (depth == 1) {
+                    current = nullptr;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+};
+
+// A track list whose older part lives in a TrackFile and whose newer
+// part (journal replay, this session's changes) in memory. Reading entry
+// i parses that one record; nothing else is touched.
+class TrackList {
+public:
+    // Replaces the whole list with `array_key` of `snapshot`
+    void attach(std::shared_ptr<TrackFile> snapshot, const std::string& array_key) {
+        file = std::move(snapshot);
+        key = array_key;
+        loaded.clear();
+        file_records = nullptr;
+        tail.clear();
     }
 
-    // Clear existing vectors
-    recentlyPlayed.clear();
-    favorites_tracks.clear();
+    size_t size() { return file_part().size() + tail.size(); }
+    bool empty() { return size() == 0; }
 
-    // Load recently played tracks
-    if (doc.HasMember("recentlyPlayed") && doc["recentlyPlayed"].IsArray()) {
-        for (const auto& trackJson : doc["recentlyPlayed"].GetArray()) {
-            Track track;
-            track.name = trackJson["name"].GetString();
-            track.artist = trackJson["artist"].GetString();
-            track.url = trackJson["url"].GetString();
-            recentlyPlayed.push_back(track);
+    // Unreadable records come back as an empty Track
+    const Track& at(size_t index) {
+        const auto& records = file_part();
+        if (index >= records.size()) {
+            return tail[index - records.size()];
         }
+        if (loaded.size() != records.size()) {
+            loaded.resize(records.size());
+        }
+        if (!loaded[index]) {
+            loaded[index] = std::make_unique<Track>();
+            file->parse(records[index], *loaded[index]);
+        }
+        return *loaded[index];
+    }
+
+    // Track::key() of entry i. A record not read yet is parsed into a
+    // throwaway Track, so indexing a whole list keeps none of them.
+    std::string key_at(size_t index) {
+        const auto& records = file_part();
+        if (index >= records.size() || (index < loaded.size() && loaded[index])) {
+            return at(index).key();
+        }
+        Track track;
+        file->parse(records[index], track);
+        return track.key();
+    }
+
+    void push_back(Track track) { tail.push_back(std::move(track)); }
+
+    // Everything, parsed; compaction and whole-list edits only
+    std::vector<Track> to_vector() {
+        std::vector<Track> all;
+        size_t count = size();
+        all.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            all.push_back(at(i));
+        }
+        return all;
     }
 
-    // Load favorite tracks
-    if (doc.HasMember("favorites") && doc["favorites"].IsArray()) {
-        for (const auto& trackJson : doc["favorites"].GetArray()) {
-            Track track;
-            track.name = trackJson["name"].GetString();
-            track.artist = trackJson["artist"].GetString();
-            track.url = trackJson["url"].GetString();
-            favorites_tracks.push_back(track);
+    // Pulls the file part into memory first; rare enough not to matter
+    template <typename Predicate> void erase_if(Predicate predicate) {
+        if (file) {
+            std::vector<Track> all = to_vector();
+            attach(nullptr, key);
+            tail = std::move(all);
+        }
+        tail.erase(std::remove_if(tail.begin(), tail.end(), predicate), tail.end());
+    }
+
+private:
+    std::shared_ptr<TrackFile> file;
+    std::string key;
+    const std::vector<TrackFile::Span>* file_records = nullptr;
+    std::vector<std::unique_ptr<Track>> loaded;
+    std::vector<Track> tail;
+
+    const std::vector<TrackFile::Span>& file_part() {
+        static const std::vector<TrackFile::Span> none;
+        if (!file) {
+            return none;
+        }
+        if (!file_records) {
+            file_records = &file->records(key);
+        }
+        return *file_records;
+    }
+};
+
+// Lists shown at the end of the last session, painted on the first frame
+// of the next one while fresh data is fetched
+struct SessionSnapshot {
+    std::vector<Track> trending;
+    std::vector<Track> home; // last search results
+    std::string query;
+};
+
+namespace {
+
+constexpr int kSessionVersion = 1;
+
+std::string session_file() {
+    return paths::get_cache_dir() + "/session.json";
+}
+
+// Tracks as [name, artist, url, id, source] rows, without repeated keys
+rapidjson::Value tracks_to_rows(const std::vector<Track>& tracks,
+                                rapidjson::Document::AllocatorType& allocator) {
+    rapidjson::Value rows(rapidjson::kArrayType);
+    rows.Reserve(static_cast<rapidjson::SizeType>(tracks.size()), allocator);
+    for (const auto& track : tracks) {
+        rapidjson::Value row(rapidjson::kArrayType);
+        for (const std::string* field : {&track.name, &track.artist, &track.url,
+                                         &track.id, &track.source}) {
+            row.PushBack(rapidjson::StringRef(field->c_str(), field->size()), allocator);
+        }
+        rows.PushBack(row, allocator);
+    }
+    return rows;
+}
+
+void rows_to_tracks(const rapidjson::Value& doc, const char* key,
+                    std::vector<Track>& tracks) {
+    tracks.clear();
+    if (!doc.HasMember(key) || !doc[key].IsArray()) {
+        return;
+    }
+    for (const auto& row : doc[key].GetArray()) {
+        if (!row.IsArray() || row.Size() != 5) {
+            continue;
+        }
+        Track track;
+        std::string* fields[] = {&track.name, &track.artist, &track.url,
+                                 &track.id, &track.source};
+        bool valid = true;
+        for (rapidjson::SizeType i = 0; i < 5 && valid; ++i) {
+            valid = row[i].IsString();
+            if (valid) {
+                fields[i]->assign(row[i].GetString(), row[i].GetStringLength());
+            }
+        }
+        if (valid) {
+            tracks.push_back(std::move(track));
         }
     }
+}
+
+} // namespace
+
+// Written to a temporary file and renamed over the old snapshot, so a
+// crash mid-write leaves the previous one intact
+void saveSession(const SessionSnapshot& session) {
+    rapidjson::Document doc;
+    doc.SetObject();
+    auto& allocator = doc.GetAllocator();
+    doc.AddMember("version", kSessionVersion, allocator);
+    doc.AddMember("query", rapidjson::StringRef(session.query.c_str(), session.query.size()),
+                  allocator);
+    rapidjson::Value trending = tracks_to_rows(session.trending, allocator);
+    doc.AddMember("trending", trending, allocator);
+    rapidjson::Value home = tracks_to_rows(session.home, allocator);
+    doc.AddMember("home", home, allocator);
 
+    std::string cache_dir = paths::get_cache_dir();
+    paths::ensure_directory_exists(cache_dir);
+    std::string target = session_file();
+    std::string temp = target + ".tmp";
+    FILE* outFile = fopen(temp.c_str(), "wb");
+    if (!outFile) {
+        notifications::send("Failed to save session snapshot");
+        return;
+    }
+    char writeBuffer[65536];
+    rapidjson::FileWriteStream os(outFile, writeBuffer, sizeof(writeBuffer));
+    rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
+    doc.Accept(writer);
+    bool written = fflush(outFile) == 0;
+    written = fclose(outFile) == 0 && written;
+    if (!written || std::rename(temp.c_str(), target.c_str()) != 0) {
+        std::remove(temp.c_str());
+        notifications::send("Failed to save session snapshot");
+    }
+}
+
+// False on a first run or an unreadable snapshot; the caller starts empty
+bool loadSession(SessionSnapshot& session) {
+    FILE* inFile = fopen(session_file().c_str(), "rb");
+    if (!inFile) {
+        return false;
+    }
+    char readBuffer[65536];
+    rapidjson::FileReadStream is(inFile, readBuffer, sizeof(readBuffer));
+    rapidjson::Document doc;
+    doc.ParseStream(is);
+    fclose(inFile);
+
+    if (doc.HasParseError() || !doc.IsObject() || !doc.HasMember("version") ||
+        !doc["version"].IsInt() || doc["version"].GetInt() != kSessionVersion) {
+        return false;
+    }
+    rows_to_tracks(doc, "trending", session.trending);
+    rows_to_tracks(doc, "home", session.home);
+    session.query = doc.HasMember("query") && doc["query"].IsString()
+                        ? doc["query"].GetString()
+                        : "";
     return true;
 }
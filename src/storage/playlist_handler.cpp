@@ -1,68 +1,136 @@
 #include "../common/Track.h"
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <vector>
 
-std::unordered_set<std::string> favorites;
-std::vector<std::string> favorite_tracks_strings;
-std::vector<Track> favorite_tracks;
+// Favourites in the order they were added, once per Track::key() and
+// without a cap. The tracks live in a TrackList that TrackJournal keeps
+// durable; the key set is built on the first lookup and kept in step
+// after that, so a membership test is one hash lookup.
+class FavoriteTracks {
+public:
+    void attach(std::shared_ptr<TrackFile> snapshot, const std::string& array_key) {
+        list.attach(std::move(snapshot), array_key);
+        keys.clear();
+        indexed = false;
+    }
 
-void addToFavorites(const std::string& song) {
-    favorites.insert(song); // Add song to favorites
-}
+    bool contains(const Track& track) {
+        index();
+        return keys.count(track.key()) != 0;
+    }
 
-void removeFromFavorites(const std::string& song) {
-    favorites.erase(song); // Remove song from favorites
-}
+    // False if it was already a favourite
+    bool add(const Track& track) {
+        index();
+        if (!keys.insert(track.key()).second) {
+            return false;
+        }
+        list.push_back(track);
+        return true;
+    }
+
+    // False if it wasn't one
+    bool remove(const Track& track) {
+        index();
+        std::string key = track.key();
+        if (keys.erase(key) == 0) {
+            return false;
+        }
+        list.erase_if([&key](const Track& t) { return t.key() == key; });
+        return true;
+    }
+
+    size_t size() { return list.size(); }
+    const Track& at(size_t index) { return list.at(index); }
+
+    // `count` favourites from `offset` on, oldest first
+    std::vector<Track> page(size_t offset, size_t count) {
+        std::vector<Track> result;
+        size_t end = std::min(size(), offset + count);
+        for (size_t i = offset; i < end; ++i) {
+            result.push_back(list.at(i));
+        }
+        return result;
+    }
+
+    std::vector<Track> to_vector() { return list.to_vector(); }
+
+private:
+    TrackList list;
+    std::unordered_set<std::string> keys;
+    bool indexed = false;
 
-bool isFavorite(const std::string& song) {
-    return favorites.find(song) != favorites.end();
+    // Lists saved before favourites were keyed may hold the same track
+    // more than once; the first of each stays
+    void index() {
+        if (indexed) {
+            return;
+        }
+        indexed = true;
+        bool duplicates = false;
+        for (size_t i = 0, count = list.size(); i < count; ++i) {
+            duplicates |= !keys.insert(list.key_at(i)).second;
+        }
+        if (duplicates) {
+            std::unordered_set<std::string> seen;
+            list.erase_if([&seen](const Track& t) { return !seen.insert(t.key()).second; });
+        }
+    }
+};
+
+std::vector<std::string> favorite_tracks_strings;
+FavoriteTracks favorite_tracks;
+
+bool isFavorite(const Track& track) {
+    return favorite_tracks.contains(track);
 }
 
 std::vector<Track> getFavoriteTracks() {
-    return favorite_tracks;
+    return favorite_tracks.to_vector();
 }
 
 std::vector<std::string> getFavoriteTracksString() {
-
-  for (const auto &fav : favorite_tracks) {
+  favorite_tracks_strings.clear();
+  for (const auto &fav : favorite_tracks.to_vector()) {
     favorite_tracks_strings.push_back(fav.to_string());
   }
     return favorite_tracks_strings;
 }
 
 
-auto fetch_favorites(std::vector<Track> track_data) {
-  // temp_track_data = track_data;
-  // Clear previous data
+// The favourites view is read a page at a time: opening it parses the
+// first page, and more_favorites() adds pages as the list scrolls on.
+constexpr size_t kFavoritesPage = 64;
+bool favorites_listed = false; // the track list shows favourites right now
+
+// Favourites oldest first, the first page of them
+auto fetch_favorites(std::vector<Track> &track_data) {
+  favorites_listed = true;
   favorite_tracks_strings.clear();
-  track_data.clear();
-
-  // Limit recently played to last 10 unique tracks
-  std::vector<Track> unique_favorite_tracks;
-  for (const auto &track : favorite_tracks) {
-    // Check if this exact track is not already in unique list
-    auto it = std::find_if(unique_favorite_tracks.begin(), unique_favorite_tracks.end(),
-        [&track](const Track& existing) { return existing.to_string() == track.to_string(); });
-    
-    if (it == unique_favorite_tracks.end()) {
-      unique_favorite_tracks.push_back(track);
-    }
-  }
+  track_data = favorite_tracks.page(0, kFavoritesPage);
 
-  // Keep only the last 10 tracks
-  if (unique_favorite_tracks.size() > 10) {
-    unique_favorite_tracks = std::vector<Track>(
-      unique_favorite_tracks.end() - 10, 
-      unique_favorite_tracks.end()
-    );
+  favorite_tracks_strings.reserve(track_data.size());
+  for (const auto &favorite : track_data) {
+    favorite_tracks_strings.push_back(favorite.to_string());
   }
+  return favorite_tracks_strings;
+}
 
-  // Populate track_data and recently_played_strings
-  track_data = unique_favorite_tracks;
-  for (const auto &recent : track_data) {
-    favorite_tracks_strings.push_back(recent.to_string());
+// Grows the favourites view to at least `rows` entries, whole pages at a
+// time, or to all of them; nothing while another list is shown
+void more_favorites(std::vector<Track> &track_data,
+                    std::vector<std::string> &track_strings, size_t rows) {
+  if (!favorites_listed || rows <= track_data.size() ||
+      track_data.size() != track_strings.size()) {
+    return;
+  }
+  size_t shown = track_data.size();
+  size_t wanted = (rows + kFavoritesPage - 1) / kFavoritesPage * kFavoritesPage;
+  for (auto &favorite : favorite_tracks.page(shown, wanted - shown)) {
+    track_strings.push_back(favorite.to_string());
+    track_data.push_back(std::move(favorite));
   }
-  return favorite_tracks_strings;
 }
@@ -0,0 +1,319 @@
+#include "../common/Track.h"
+#include "../common/paths.hpp"
+#include "../common/notification.hpp"
+#include "rapidjson/document.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Append-only log of history and favourite changes on top of the
+// tracks.json snapshot. Each play or favourite change is one line,
+//
+//   <crc32 as 8 hex digits> {"seq":N,"op":"play","track":[name,artist,url,id,source]}
+//
+// written with a single write(2), so a crash loses at most the record in
+// flight. Recovery maps the snapshot and replays the records after it,
+// stopping at the first line whose checksum fails; every
+// `compact_every` records the lists are written out as a new snapshot
+// (temp file + rename) and the journal starts over, which keeps replay
+// bounded. The snapshot keeps only the newest plays; the full history
+// with play times is HistoryStore's.
+//
+// One instance owns the journal at a time, by an flock on it taken in
+// recover(). A second one would append records with the same seq and
+// compact over the first one's snapshot, so it loads the lists but
+// writes neither file, nor HistoryStore's history.log; its changes last
+// until it exits.
+class TrackJournal {
+public:
+  enum class Sync { Always, Interval, Never };
+
+  static Sync parse_sync(const std::string &name) {
+    if (name == "never") return Sync::Never;
+    if (name == "interval") return Sync::Interval;
+    return Sync::Always;
+  }
+
+  TrackJournal(TrackList &recent, FavoriteTracks &favorites, HistoryStore &history,
+               Sync policy, int compact_every)
+      : recent(recent), favorites(favorites), history(history), policy(policy),
+        compact_every(std::max(1, compact_every)) {}
+
+  ~TrackJournal() { close_file(); }
+
+  TrackJournal(const TrackJournal &) = delete;
+  TrackJournal &operator=(const TrackJournal &) = delete;
+
+  // Snapshot plus every intact record after it. A torn or corrupt tail is
+  // cut off so later appends follow the last good record. The snapshot is
+  // only mapped here; its tracks are read when a view asks for them, so
+  // this costs the journal's length, not the history's. The journal is
+  // opened and locked before it is read, so the records replayed are the
+  // ones a trim or compaction here keeps.
+  void recover() {
+    open_file();
+    auto snapshot = TrackFile::open(tracks_file_path());
+    uint64_t snapshot_seq = snapshot ? snapshot->journal_seq() : 0;
+    recent.attach(snapshot, "recentlyPlayed");
+    favorites.attach(snapshot, "favorites");
+    seq = snapshot_seq;
+    records = 0;
+
+    std::string path = journal_path();
+    FILE *file = fopen(path.c_str(), "rb");
+    long good_end = 0;
+    if (file) {
+      std::string line;
+      int c;
+      long offset = 0;
+      while ((c = fgetc(file)) != EOF) {
+        offset++;
+        if (c != '\n') {
+          line.push_back(static_cast<char>(c));
+          continue;
+        }
+        if (!replay(line, snapshot_seq)) {
+          break;
+        }
+        good_end = offset;
+        line.clear();
+      }
+      fclose(file);
+    }
+
+    if (fd >= 0 && ::ftruncate(fd, good_end) != 0) {
+      notifications::send("Failed to trim track journal");
+    }
+    if (!read_only && records >= compact_every) {
+      compact();
+    }
+  }
+
+  void record_play(const Track &track) {
+    recent.push_back(track);
+    history.record(track);
+    append("play", track);
+  }
+
+  // False, and nothing logged, if the track already was (or wasn't) one
+  bool record_favorite(const Track &track, bool added) {
+    if (!(added ? favorites.add(track) : favorites.remove(track))) {
+      return false;
+    }
+    append(added ? "fav_add" : "fav_remove", track);
+    return true;
+  }
+
+  // Writes the lists as the new snapshot and empties the journal. Until
+  // the rename is durable (saveData syncs the directory too) the old
+  // snapshot and the full journal stay valid, so the journal is only
+  // truncated once saveData reports success; after that, records up to
+  // `seq` are skipped on replay even if the truncate never happens. The
+  // lists are then read back from the new snapshot, which drops plays
+  // past the limit from memory too.
+  void compact() {
+    if (read_only) {
+      return;
+    }
+    std::vector<Track> plays = recent.to_vector();
+    if (plays.size() > history.ring_capacity()) {
+      plays.erase(plays.begin(), plays.end() - history.ring_capacity());
+    }
+    // Either way the next attempt waits for another `compact_every`
+    // records, rather than rewriting tracks.json on every append
+    records = 0;
+    if (!saveData(plays, favorites.to_vector(), seq)) {
+      return;
+    }
+    if (fd >= 0 && ::ftruncate(fd, 0) == 0) {
+      sync_now();
+    }
+    auto snapshot = TrackFile::open(tracks_file_path());
+    recent.attach(snapshot, "recentlyPlayed");
+    favorites.attach(snapshot, "favorites");
+  }
+
+  // Durable point for the "interval" policy, e.g. before exit
+  void flush() {
+    if (policy != Sync::Never) {
+      sync_now();
+    }
+  }
+
+private:
+  static constexpr auto kSyncInterval = std::chrono::seconds(1);
+
+  TrackList &recent;
+  FavoriteTracks &favorites;
+  HistoryStore &history;
+  Sync policy;
+  int compact_every;
+  int fd = -1;
+  bool read_only = false; // another instance holds the journal lock
+  uint64_t seq = 0;  // last record written or replayed
+  int records = 0;   // records since the last compaction attempt
+  std::chrono::steady_clock::time_point last_sync{};
+
+  static std::string journal_path() {
+    return paths::get_data_dir() + "/journal.jsonl";
+  }
+
+  static uint32_t crc32(const char *data, size_t size) {
+    static const auto table = [] {
+      std::array<uint32_t, 256> entries{};
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+          c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        entries[i] = c;
+      }
+      return entries;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+      crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+  }
+
+  void open_file() {
+    std::string dir = paths::get_data_dir();
+    paths::ensure_directory_exists(dir);
+    fd = ::open(journal_path().c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                0600);
+    if (fd < 0) {
+      notifications::send(std::string("Track journal unavailable: ") +
+                          std::strerror(errno));
+      return;
+    }
+    // Held until the fd is closed, so a crash can't leave it stale. Other
+    // failures (a file system without locks) journal unlocked, as before.
+    if (::flock(fd, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK) {
+      read_only = true;
+      history.set_read_only();
+      ::close(fd);
+      fd = -1;
+      notifications::send("Another tuisic is running; history and favourites "
+                          "changed here won't be saved");
+    }
+  }
+
+  void close_file() {
+    if (fd >= 0) {
+      flush();
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  void sync_now() {
+    if (fd >= 0) {
+      ::fsync(fd);
+      last_sync = std::chrono::steady_clock::now();
+    }
+  }
+
+  void append(const char *op, const Track &track) {
+    seq++;
+    if (fd < 0) {
+      return; // the lists still change; tracks.json gets them on compaction
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("seq");
+    writer.Uint64(seq);
+    writer.Key("op");
+    writer.String(op);
+    writer.Key("track");
+    writer.StartArray();
+    for (const std::string *field : {&track.name, &track.artist, &track.url,
+                                     &track.id, &track.source}) {
+      writer.String(field->c_str(), static_cast<rapidjson::SizeType>(field->size()));
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    char checksum[10];
+    std::snprintf(checksum, sizeof(checksum), "%08x ",
+                  crc32(buffer.GetString(), buffer.GetSize()));
+    std::string line = checksum;
+    line.append(buffer.GetString(), buffer.GetSize());
+    line.push_back('\n');
+
+    if (::write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+      notifications::send("Failed to append to track journal");
+      return;
+    }
+    records++;
+
+    if (policy == Sync::Always ||
+        (policy == Sync::Interval &&
+         std::chrono::steady_clock::now() - last_sync >= kSyncInterval)) {
+      sync_now();
+    }
+    if (records >= compact_every) {
+      compact();
+    }
+  }
+
+  // False when the line is torn or corrupt; replay stops there
+  bool replay(const std::string &line, uint64_t snapshot_seq) {
+    if (line.size() < 10 || line[8] != ' ') {
+      return false;
+    }
+    uint32_t expected = static_cast<uint32_t>(std::strtoul(line.substr(0, 8).c_str(), nullptr, 16));
+    const char *json = line.c_str() + 9;
+    if (crc32(json, line.size() - 9) != expected) {
+      return false;
+    }
+
+    rapidjson::Document doc;
+    if (doc.Parse(json).HasParseError() || !doc.IsObject() ||
+        !doc.HasMember("seq") || !doc["seq"].IsUint64() ||
+        !doc.HasMember("op") || !doc["op"].IsString() ||
+        !doc.HasMember("track") || !doc["track"].IsArray() ||
+        doc["track"].Size() != 5) {
+      return false;
+    }
+    Track track;
+    std::string *fields[] = {&track.name, &track.artist, &track.url, &track.id,
+                             &track.source};
+    for (rapidjson::SizeType i = 0; i < 5; ++i) {
+      if (!doc["track"][i].IsString()) {
+        return false;
+      }
+      *fields[i] = doc["track"][i].GetString();
+    }
+
+    records++;
+    uint64_t record_seq = doc["seq"].GetUint64();
+    seq = std::max(seq, record_seq);
+    if (record_seq <= snapshot_seq) {
+      return true; // already in tracks.json
+    }
+    std::string op = doc["op"].GetString();
+    if (op == "play") {
+      recent.push_back(track);
+    } else if (op == "fav_add") {
+      favorites.add(track);
+    } else if (op == "fav_remove") {
+      favorites.remove(track);
+    }
+    return true;
+  }
+};
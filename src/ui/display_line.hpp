@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/box.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <ftxui/screen/string.hpp>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// A list entry with its terminal width measured once. The cells it is
+// drawn with are cut to fit a pane width and kept until that width
+// changes, so long CJK or emoji titles are only scanned again on resize.
+class DisplayLine {
+public:
+  explicit DisplayLine(std::string value)
+      : value(std::move(value)), columns(ftxui::string_width(this->value)) {}
+
+  const std::string &text() const { return value; }
+  int width() const { return columns; }
+
+  // One string per terminal cell, ending in "…" when the text is cut. A
+  // wide glyph is followed by an empty cell, as in ftxui's own Text.
+  const std::vector<std::string> &fit(int available) {
+    available = std::max(0, available);
+    if (available == fitted_for) {
+      return cells;
+    }
+    fitted_for = available;
+    cells = ftxui::Utf8ToGlyphs(value);
+    if (static_cast<int>(cells.size()) > available) {
+      int keep = std::max(0, available - 1);
+      // Cutting between a wide glyph and its empty cell would leave half
+      // a glyph; blank it instead
+      bool split_glyph = keep > 0 && cells[keep].empty();
+      cells.resize(keep);
+      if (split_glyph) {
+        cells.back() = " ";
+      }
+      if (available > 0) {
+        cells.push_back("…");
+      }
+    }
+    return cells;
+  }
+
+private:
+  std::string value;
+  int columns;
+  std::vector<std::string> cells;
+  int fitted_for = -1;
+};
+
+// One row of a list: a short marker such as "> " and the entry after it.
+// Asks for the full width like text() does, and when the box turns out
+// narrower draws the cached ellipsized cells instead of clipping.
+class DisplayRow : public ftxui::Node {
+public:
+  DisplayRow(const char *marker, std::shared_ptr<DisplayLine> entry)
+      : marker(marker), line(std::move(entry)) {}
+
+  void ComputeRequirement() override {
+    requirement_ = {};
+    requirement_.min_x = marker_width() + line->width();
+    requirement_.min_y = 1;
+  }
+
+  void Render(ftxui::Screen &screen) override {
+    const int y = box_.y_min;
+    if (y > box_.y_max) {
+      return;
+    }
+    int x = box_.x_min;
+    for (const char *c = marker; *c && x <= box_.x_max; ++c, ++x) {
+      screen.PixelAt(x, y).character = std::string(1, *c);
+    }
+    for (const auto &cell : line->fit(box_.x_max - x + 1)) {
+      screen.PixelAt(x++, y).character = cell;
+    }
+  }
+
+private:
+  const char *marker; // ASCII only, one cell per byte
+  std::shared_ptr<DisplayLine> line;
+
+  int marker_width() const {
+    return static_cast<int>(std::char_traits<char>::length(marker));
+  }
+};
+
+// Display lines for a vector of strings, built for a row the first time it
+// is drawn and rebuilt only when the string at that index changes
+class DisplayLineCache {
+public:
+  const std::shared_ptr<DisplayLine> &at(const std::vector<std::string> &entries,
+                                         int index) {
+    if (lines.size() != entries.size()) {
+      lines.resize(entries.size());
+    }
+    auto &line = lines[index];
+    if (!line || line->text() != entries[index]) {
+      line = std::make_shared<DisplayLine>(entries[index]);
+    }
+    return line;
+  }
+
+private:
+  std::vector<std::shared_ptr<DisplayLine>> lines;
+};
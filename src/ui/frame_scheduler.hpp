@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fmt/format.h>
+#include <ftxui/dom/elements.hpp>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Single path from "something changed" to a redraw. Producers mark the
+// regions they touched; the first mark in a frame asks for one redraw, no
+// sooner than the frame cap allows, and every later mark until that frame
+// is drawn rides along. The renderer takes the dirty set at the top of
+// the frame and rebuilds only those regions.
+class FrameScheduler {
+public:
+  enum Region : unsigned {
+    Header = 1u << 0,     // title, artist, clock
+    Progress = 1u << 1,   // progress bar and transport buttons
+    Lyrics = 1u << 2,     // subtitle / lyric line
+    List = 1u << 3,       // playlists, search, track lists
+    Visualizer = 1u << 4,
+    Volume = 1u << 5,
+    All = ~0u,
+  };
+
+  using Post = std::function<void()>;
+
+  static constexpr int kMinFps = 1;
+  static constexpr int kMaxFps = 120;
+
+  // The worker thread starts with the first invalidate(), so modes that
+  // never draw (--cmd, --mcp-server, --daemon) never start it
+  FrameScheduler(int max_fps, Post post)
+      : period(period_for(max_fps)), post(std::move(post)) {}
+
+  ~FrameScheduler() { stop(); }
+
+  FrameScheduler(const FrameScheduler &) = delete;
+  FrameScheduler &operator=(const FrameScheduler &) = delete;
+
+  void set_max_fps(int fps) {
+    std::lock_guard<std::mutex> lock(mutex);
+    period = period_for(fps);
+  }
+
+  // Any thread: mark regions and make sure a frame is coming
+  void invalidate(unsigned regions) {
+    dirty.fetch_or(regions, std::memory_order_relaxed);
+    requests.fetch_add(1, std::memory_order_relaxed);
+    if (!scheduled.exchange(true, std::memory_order_acq_rel)) {
+      std::call_once(started, [this] { worker = std::thread([this] { run(); }); });
+      std::lock_guard<std::mutex> lock(mutex);
+      wake.notify_one();
+    }
+  }
+
+  // Mark regions for a frame that is already coming (input events, or
+  // changes that should wait for the next one)
+  void touch(unsigned regions) {
+    dirty.fetch_or(regions, std::memory_order_relaxed);
+  }
+
+  // Render thread, top of every frame: the regions to rebuild
+  unsigned begin_frame() {
+    frames++;
+    auto now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - window_start).count();
+    if (elapsed >= 1.0) {
+      uint64_t total = requests.load(std::memory_order_relaxed);
+      frame_rate = frames / elapsed;
+      request_rate = (total - window_requests) / elapsed;
+      frames = 0;
+      window_requests = total;
+      window_start = now;
+    }
+    return dirty.exchange(0, std::memory_order_acq_rel);
+  }
+
+  // Render thread: e.g. "12 fps / 140 req/s" over the last second
+  std::string summary() const {
+    return fmt::format("{:.0f} fps / {:.0f} req/s", frame_rate, request_rate);
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  static Clock::duration period_for(int fps) {
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / std::clamp(fps, kMinFps, kMaxFps)));
+  }
+
+  std::atomic<unsigned> dirty{All};
+  std::atomic<bool> scheduled{false};
+  std::atomic<uint64_t> requests{0};
+
+  // Render-thread statistics
+  Clock::time_point window_start = Clock::now();
+  uint64_t window_requests = 0;
+  uint64_t frames = 0;
+  double frame_rate = 0;
+  double request_rate = 0;
+
+  std::mutex mutex;
+  std::condition_variable wake;
+  Clock::duration period;
+  bool stopping = false;
+  Post post;
+  std::once_flag started;
+  std::thread worker;
+
+  void run() {
+    auto last_post = Clock::now() - period;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+      wake.wait(lock, [this] {
+        return stopping || scheduled.load(std::memory_order_acquire);
+      });
+      if (stopping) {
+        break;
+      }
+      // Cap the rate; marks arriving meanwhile join this frame
+      auto due = last_post + period;
+      if (wake.wait_until(lock, due, [this] { return stopping; })) {
+        break;
+      }
+      last_post = Clock::now();
+      lock.unlock();
+      // Cleared before posting so a mark during the draw gets a new frame
+      scheduled.store(false, std::memory_order_release);
+      post();
+      lock.lock();
+    }
+  }
+};
+
+// Keeps a region's element tree between frames; layout still runs every
+// frame, only building the tree is skipped while the region is clean
+class CachedRegion {
+public:
+  template <typename Build>
+  ftxui::Element get(unsigned dirty, unsigned region, Build &&build) {
+    if (!element || (dirty & region)) {
+      element = build();
+    }
+    return element;
+  }
+
+private:
+  ftxui::Element element;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../common/mpsc_queue.hpp"
+#include "frame_scheduler.hpp"
+#include <functional>
+#include <utility>
+
+// The UI thread owns the state the renderer reads. Other threads (fetch
+// tasks, mpv callbacks, D-Bus) don't write it; they post a delta, and the
+// UI thread applies every pending delta at the top of the next frame, so
+// a frame always sees state as of one point and the render path takes no
+// locks.
+class UiStore {
+public:
+  using Delta = std::function<void()>;
+
+  explicit UiStore(FrameScheduler &scheduler) : scheduler(scheduler) {}
+
+  // Any thread: apply `delta` before the next frame and redraw `regions`
+  void post(unsigned regions, Delta delta) {
+    deltas.push(std::move(delta));
+    scheduler.invalidate(regions);
+  }
+
+  // Any thread: like post(), but rides along with whatever frame comes
+  // next instead of asking for one
+  void defer(unsigned regions, Delta delta) {
+    deltas.push(std::move(delta));
+    scheduler.touch(regions);
+  }
+
+  // UI thread, before the frame reads any state
+  void drain() {
+    Delta delta;
+    while (deltas.pop(delta)) {
+      delta();
+    }
+  }
+
+private:
+  FrameScheduler &scheduler;
+  MpscQueue<Delta> deltas;
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "display_line.hpp"
+#include <algorithm>
+#include <ftxui/component/component.hpp>
+#include <ftxui/component/component_base.hpp>
+#include <ftxui/component/event.hpp>
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/box.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Rows [first, first + children) of a longer list, drawn so that row
+// `top` sits on the first line of the box. Rows above or below the box
+// are laid out by nobody and drawn by nobody; they only exist as overscan.
+class VirtualRows : public ftxui::Node {
+public:
+  VirtualRows(ftxui::Elements rows, int first_line)
+      : ftxui::Node(std::move(rows)), offset(first_line) {}
+
+  void ComputeRequirement() override {
+    requirement_ = {};
+    for (auto &row : children_) {
+      row->ComputeRequirement();
+      requirement_.min_x = std::max(requirement_.min_x, row->requirement().min_x);
+    }
+    requirement_.min_y = 1;
+    requirement_.flex_grow_x = requirement_.flex_shrink_x = 1;
+    requirement_.flex_grow_y = requirement_.flex_shrink_y = 1;
+  }
+
+  void SetBox(ftxui::Box box) override {
+    Node::SetBox(box);
+    for (int i = 0; i < static_cast<int>(children_.size()); ++i) {
+      int y = box.y_min + i - offset;
+      if (y >= box.y_min && y <= box.y_max) {
+        children_[i]->SetBox({box.x_min, box.x_max, y, y});
+      }
+    }
+  }
+
+  void Render(ftxui::Screen &screen) override {
+    for (int i = 0; i < static_cast<int>(children_.size()); ++i) {
+      int y = box_.y_min + i - offset;
+      if (y >= box_.y_min && y <= box_.y_max) {
+        children_[i]->Render(screen);
+      }
+    }
+  }
+
+private:
+  int offset; // index into children_ of the row on the first line
+};
+
+struct VirtualListOption {
+  int overscan = 4;      // extra rows built above and below the view
+  int initial_rows = 22; // view height before the first layout
+  // Rows for which this is true get a '*' next to the cursor column.
+  // Asked only for rows being drawn, so it has to be cheap, not global.
+  std::function<bool(int index)> marked;
+  // Asked for at least this many rows before each render and key press;
+  // a list read in pages appends to `entries` here
+  std::function<void(int rows)> fill;
+};
+
+// Drop-in for Menu(&entries, &selected) on lists of any length. Selection
+// and scroll position are plain indices; each frame only the rows in view
+// plus the overscan are turned into elements, so rendering costs
+// O(visible rows) whether the list holds 40 entries or 20k. Rows draw
+// from a DisplayLineCache, so their width is not measured every layout.
+class VirtualListBase : public ftxui::ComponentBase {
+public:
+  VirtualListBase(const std::vector<std::string> *entries, int *selected,
+                  VirtualListOption option)
+      : entries(entries), selected(selected), option(option),
+        rows(std::max(1, option.initial_rows)) {}
+
+  ftxui::Element OnRender() override {
+    using namespace ftxui;
+    request(top + rows + option.overscan);
+    const int count = static_cast<int>(entries->size());
+    if (count == 0) {
+      return text("") | reflect(box);
+    }
+    *selected = std::clamp(*selected, 0, count - 1);
+    scroll_into_view();
+
+    int first = std::max(0, top - option.overscan);
+    int last = std::min(count, top + rows + option.overscan);
+    const bool focused = Focused();
+
+    Elements visible;
+    visible.reserve(last - first);
+    for (int i = first; i < last; ++i) {
+      bool active = i == *selected;
+      Element row = std::make_shared<DisplayRow>(marker(active, i),
+                                                 lines.at(*entries, i));
+      if (active) {
+        row = focused ? row | inverted | focus : row | bold | ftxui::select;
+      }
+      visible.push_back(std::move(row));
+    }
+    return std::make_shared<VirtualRows>(std::move(visible), top - first) |
+           reflect(box);
+  }
+
+  bool OnEvent(ftxui::Event event) override {
+    using ftxui::Event;
+    if (event.is_mouse()) {
+      return on_mouse(event);
+    }
+    if (!Focused() || entries->empty()) {
+      return false;
+    }
+
+    // Room for a page down from here, or one more page on End
+    request(*selected + rows + option.overscan + 1);
+    const int count = static_cast<int>(entries->size());
+    int target = *selected;
+    if (event == Event::ArrowUp || event == Event::Character('k')) {
+      target--;
+    } else if (event == Event::ArrowDown || event == Event::Character('j')) {
+      target++;
+    } else if (event == Event::PageUp) {
+      target -= rows;
+    } else if (event == Event::PageDown) {
+      target += rows;
+    } else if (event == Event::Home) {
+      target = 0;
+    } else if (event == Event::End) {
+      target = count - 1;
+    } else {
+      return false;
+    }
+    target = std::clamp(target, 0, count - 1);
+    if (target == *selected) {
+      return false; // let the container move focus past the ends
+    }
+    *selected = target;
+    return true;
+  }
+
+  bool Focusable() const override { return true; }
+
+private:
+  const std::vector<std::string> *entries;
+  int *selected;
+  VirtualListOption option;
+  DisplayLineCache lines;
+  ftxui::Box box;
+  int top = 0;  // index of the row on the first line
+  int rows;     // lines in view as of the last layout
+
+  void request(int wanted) {
+    if (option.fill) {
+      option.fill(wanted);
+    }
+  }
+
+  const char *marker(bool active, int index) const {
+    if (!option.marked) {
+      return active ? "> " : "  ";
+    }
+    if (option.marked(index)) {
+      return active ? ">* " : " * ";
+    }
+    return active ? ">  " : "   ";
+  }
+
+  void scroll_into_view() {
+    if (box.y_max >= box.y_min) {
+      rows = std::max(1, box.y_max - box.y_min + 1);
+    }
+    const int count = static_cast<int>(entries->size());
+    if (*selected < top) {
+      top = *selected;
+    } else if (*selected >= top + rows) {
+      top = *selected - rows + 1;
+    }
+    top = std::clamp(top, 0, std::max(0, count - rows));
+  }
+
+  bool on_mouse(ftxui::Event &event) {
+    using ftxui::Mouse;
+    auto &mouse = event.mouse();
+    if (!box.Contain(mouse.x, mouse.y) || entries->empty()) {
+      return false;
+    }
+    const int count = static_cast<int>(entries->size());
+    if (mouse.button == Mouse::WheelUp || mouse.button == Mouse::WheelDown) {
+      // The wheel scrolls the view; the selection follows only if it
+      // would otherwise leave it
+      top += mouse.button == Mouse::WheelUp ? -3 : 3;
+      top = std::clamp(top, 0, std::max(0, count - rows));
+      *selected = std::clamp(*selected, top, std::min(count, top + rows) - 1);
+      return true;
+    }
+    if (mouse.button == Mouse::Left && mouse.motion == Mouse::Pressed) {
+      int index = top + (mouse.y - box.y_min);
+      if (index < count) {
+        *selected = index;
+        TakeFocus();
+      }
+      return true;
+    }
+    return false;
+  }
+};
+
+inline ftxui::Component VirtualList(const std::vector<std::string> *entries,
+                                    int *selected,
+                                    VirtualListOption option = {}) {
+  return ftxui::Make<VirtualListBase>(entries, selected, option);
+}
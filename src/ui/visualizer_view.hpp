@@ -0,0 +1,78 @@
+#pragma once
+
+#include "../audio/bar_kernels.hpp"
+#include <algorithm>
+#include <ftxui/dom/elements.hpp>
+#include <ftxui/dom/node.hpp>
+#include <ftxui/screen/color.hpp>
+#include <ftxui/screen/screen.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Spectrum bars drawn straight into the screen. Layout tells the node how
+// wide it is; it reports how many bars fit and draws whatever count the
+// DSP thread last published.
+class VisualizerView : public ftxui::Node {
+public:
+  static constexpr int kHeight = 8;
+  static constexpr int kColumnsPerBar = 2; // gap + block
+
+  // `levels` must outlive the frame; the player's read buffer does
+  VisualizerView(const std::vector<double> &levels,
+                 std::function<void(int)> on_fit)
+      : levels(levels), on_fit(std::move(on_fit)) {}
+
+  void ComputeRequirement() override {
+    requirement_.min_x = bars::kMin * kColumnsPerBar;
+    requirement_.min_y = kHeight;
+    requirement_.flex_grow_x = 1;
+    requirement_.flex_shrink_x = 1;
+  }
+
+  void SetBox(ftxui::Box box) override {
+    Node::SetBox(box);
+    if (on_fit) {
+      on_fit(bars::snap((box.x_max - box.x_min + 1) / kColumnsPerBar));
+    }
+  }
+
+  void Render(ftxui::Screen &screen) override {
+    using ftxui::Color;
+    const int count = static_cast<int>(levels.size());
+    if (count == 0) {
+      return;
+    }
+    const int width = box_.x_max - box_.x_min + 1;
+    const int height = std::min(box_.y_max - box_.y_min + 1, kHeight);
+    const int bar_width = std::max(1, width / count);
+    const int gap = bar_width >= kColumnsPerBar ? 1 : 0;
+    const int left = box_.x_min + std::max(0, (width - bar_width * count) / 2);
+
+    for (int i = 0; i < count; ++i) {
+      // The bottom row is a dim base, always drawn
+      int filled = std::clamp(static_cast<int>(levels[i] * height), 1, height);
+      Color bar_color = filled <= height / 3         ? Color::Green
+                        : filled <= (height * 2) / 3 ? Color::Yellow
+                                                     : Color::Red;
+
+      int x_end = std::min(left + (i + 1) * bar_width, box_.x_max + 1);
+      for (int x = left + i * bar_width + gap; x < x_end; ++x) {
+        for (int row = 0; row < filled; ++row) {
+          auto &pixel = screen.PixelAt(x, box_.y_max - row);
+          pixel.character = row == 0 ? "▁" : "█";
+          pixel.foreground_color = row == 0 ? Color::GrayDark : bar_color;
+        }
+      }
+    }
+  }
+
+private:
+  const std::vector<double> &levels;
+  std::function<void(int)> on_fit;
+};
+
+inline ftxui::Element visualizer_view(const std::vector<double> &levels,
+                                      std::function<void(int)> on_fit) {
+  return std::make_shared<VisualizerView>(levels, std::move(on_fit));
+}